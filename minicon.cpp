@@ -5,106 +5,506 @@
 #include <set>
 #include <algorithm>
 #include <sstream>
+#include <memory>
+#include <unordered_map>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <list>
+#include <shared_mutex>
+#include <limits>
+#include <iomanip>
+#include <cmath>
+#include <random>
+#include <fstream>
+#include <cstdio>
+#include <string_view>
+#include <cstring>
+#include <charconv>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 using namespace std;
 // ============================================================================
 // DATA STRUCTURES
 // ============================================================================
 
+// Interns relation, variable and constant names into dense integer IDs so
+// the rewriting core compares and copies ints; names are looked up again
+// only when printing or emitting SQL. One table is shared by a query and
+// every view it is rewritten against. Queries may be converted while
+// other threads rewrite, so the table locks internally; names live in a
+// deque, which keeps the references name() returns valid as it grows.
+class SymbolTable {
+public:
+    int intern(const string& name) {
+        {
+            shared_lock<shared_mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) return it->second;
+        }
+        unique_lock<shared_mutex> lock(mutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        int id = names.size();
+        names.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
+    
+    // Returns -1 if the name has never been interned
+    int lookup(const string& name) const {
+        shared_lock<shared_mutex> lock(mutex);
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+    
+    const string& name(int id) const {
+        shared_lock<shared_mutex> lock(mutex);
+        return names[id];
+    }
+    
+    size_t size() const {
+        shared_lock<shared_mutex> lock(mutex);
+        return names.size();
+    }
+    
+private:
+    mutable shared_mutex mutex;
+    deque<string> names;
+    unordered_map<string, int> ids;
+};
+
 // Represents a term in a predicate (variable or constant)
 struct Term {
-    string value;
+    int id;             // Symbol ID of the variable or constant
     bool is_variable;
     
-    Term(const string& v = "", bool var = true) 
-        : value(v), is_variable(var) {}
+    Term(int i = -1, bool var = true) 
+        : id(i), is_variable(var) {}
     
     bool operator==(const Term& other) const {
-        return value == other.value && is_variable == other.is_variable;
+        return id == other.id && is_variable == other.is_variable;
     }
     
     bool operator<(const Term& other) const {
         if (is_variable != other.is_variable) return is_variable;
-        return value < other.value;
+        return id < other.id;
     }
 };
 
 // Represents a relational atom: R(t1, t2, ..., tn)
 struct Atom {
-    string relation;
+    int relation;       // Symbol ID of the relation name
     vector<Term> terms;
+    bool nullable = false;  // Null-supplied side of an outer join (views only)
     
-    Atom(const string& rel = "") : relation(rel) {}
+    Atom(int rel = -1) : relation(rel) {}
     
     void addTerm(const Term& t) {
         terms.push_back(t);
     }
     
-    string toString() const {
-        string result = relation + "(";
+    string toString(const SymbolTable& symbols) const {
+        string result = symbols.name(relation) + "(";
         for (size_t i = 0; i < terms.size(); ++i) {
             if (i > 0) result += ", ";
-            result += terms[i].value;
+            result += symbols.name(terms[i].id);
         }
-        result += ")";
+        result += nullable ? ")?" : ")";
         return result;
     }
 };
 
-// Represents a conjunctive query: Q(head) :- body
+// Numeric values a variable may take. Each finite end is inclusive or
+// strict; infinite ends mean the side is unbounded.
+struct Interval {
+    double lo = -numeric_limits<double>::infinity();
+    double hi = numeric_limits<double>::infinity();
+    bool lo_strict = false;
+    bool hi_strict = false;
+    
+    bool empty() const {
+        return lo > hi || (lo == hi && (lo_strict || hi_strict));
+    }
+    
+    bool unbounded() const {
+        return lo == -numeric_limits<double>::infinity() && 
+               hi == numeric_limits<double>::infinity();
+    }
+    
+    void intersect(const Interval& other) {
+        if (other.lo > lo || (other.lo == lo && other.lo_strict)) {
+            lo = other.lo;
+            lo_strict = other.lo_strict;
+        }
+        if (other.hi < hi || (other.hi == hi && other.hi_strict)) {
+            hi = other.hi;
+            hi_strict = other.hi_strict;
+        }
+    }
+    
+    // Is every value of `other` also in this interval?
+    bool contains(const Interval& other) const {
+        if (other.empty()) return true;
+        bool lo_ok = lo < other.lo || (lo == other.lo && (!lo_strict || other.lo_strict));
+        bool hi_ok = hi > other.hi || (hi == other.hi && (!hi_strict || other.hi_strict));
+        return lo_ok && hi_ok;
+    }
+    
+    bool operator==(const Interval& other) const {
+        return lo == other.lo && hi == other.hi && 
+               lo_strict == other.lo_strict && hi_strict == other.hi_strict;
+    }
+    
+    string toString() const {
+        stringstream ss;
+        ss << setprecision(15) << (lo_strict ? "(" : "[") << lo << ", " << hi 
+           << (hi_strict ? ")" : "]");
+        return ss.str();
+    }
+};
+
+enum class CompareOp { Lt, Le, Gt, Ge, Eq };
+
+// Comparison atom between a variable and a numeric constant: var op value
+struct Comparison {
+    int var;
+    CompareOp op;
+    double value;
+    bool conditional = false;   // From an outer join's ON clause: holds only
+                                // on rows where the null-supplied side matched
+    
+    Interval toInterval() const {
+        Interval i;
+        switch (op) {
+            case CompareOp::Lt: i.hi = value; i.hi_strict = true; break;
+            case CompareOp::Le: i.hi = value; break;
+            case CompareOp::Gt: i.lo = value; i.lo_strict = true; break;
+            case CompareOp::Ge: i.lo = value; break;
+            case CompareOp::Eq: i.lo = i.hi = value; break;
+        }
+        return i;
+    }
+    
+    static const char* opString(CompareOp op) {
+        switch (op) {
+            case CompareOp::Lt: return "<";
+            case CompareOp::Le: return "<=";
+            case CompareOp::Gt: return ">";
+            case CompareOp::Ge: return ">=";
+            case CompareOp::Eq: return "=";
+        }
+        return "?";
+    }
+    
+    string toString(const SymbolTable& symbols) const {
+        stringstream ss;
+        if (conditional) ss << "ON ";
+        ss << setprecision(15) << symbols.name(var) << " " << opString(op) << " " << value;
+        return ss.str();
+    }
+};
+
+enum class AggregateOp { Sum, Count, Min, Max };
+
+// Aggregate in a SELECT list: op(arg) AS output
+struct Aggregate {
+    AggregateOp op;
+    int arg;        // Aggregated variable, -1 for COUNT(*)
+    int output;     // Symbol ID naming the result column
+    
+    static const char* opString(AggregateOp op) {
+        switch (op) {
+            case AggregateOp::Sum: return "SUM";
+            case AggregateOp::Count: return "COUNT";
+            case AggregateOp::Min: return "MIN";
+            case AggregateOp::Max: return "MAX";
+        }
+        return "?";
+    }
+    
+    string toString(const SymbolTable& symbols) const {
+        return string(opString(op)) + "(" + (arg == -1 ? "*" : symbols.name(arg)) + 
+               ") AS " + symbols.name(output);
+    }
+};
+
+// Represents a conjunctive query: Q(head) :- body, comparisons. An
+// aggregate query or view groups the body's rows by `group_by` and
+// outputs the head (grouping columns) followed by the aggregates.
 struct ConjunctiveQuery {
     string name;
     vector<Term> head;
     vector<Atom> body;
+    vector<Comparison> comparisons;     // Range predicates on body variables
+    // Equalities of an outer join's ON clause. Unlike inner joins they do
+    // not merge the two variables: the null-supplied one is NULL on
+    // padded rows while the other is not.
+    vector<pair<int, int>> on_equalities;
+    vector<int> group_by;
+    vector<Aggregate> aggregates;
+    shared_ptr<SymbolTable> symbols;    // Resolves the IDs used in head/body
     
     ConjunctiveQuery(const string& n = "") : name(n) {}
     
-    set<string> getVariables() const {
-        set<string> vars;
+    set<int> getVariables() const {
+        set<int> vars;
         for (const auto& t : head) {
-            if (t.is_variable) vars.insert(t.value);
+            if (t.is_variable) vars.insert(t.id);
         }
         for (const auto& atom : body) {
             for (const auto& t : atom.terms) {
-                if (t.is_variable) vars.insert(t.value);
+                if (t.is_variable) vars.insert(t.id);
             }
         }
         return vars;
     }
     
-    set<string> getHeadVariables() const {
-        set<string> vars;
+    set<int> getHeadVariables() const {
+        set<int> vars;
         for (const auto& t : head) {
-            if (t.is_variable) vars.insert(t.value);
+            if (t.is_variable) vars.insert(t.id);
         }
         return vars;
     }
     
+    // Allowed values of each compared variable (all its comparisons
+    // intersected); unconstrained variables are absent. Outer-join ON
+    // predicates count only when `with_conditional` is set.
+    map<int, Interval> intervals(bool with_conditional = false) const {
+        map<int, Interval> result;
+        for (const auto& c : comparisons) {
+            if (c.conditional && !with_conditional) continue;
+            result[c.var].intersect(c.toInterval());
+        }
+        return result;
+    }
+    
+    bool isAggregate() const { return !aggregates.empty(); }
+    
+    bool hasOuterJoin() const {
+        for (const auto& atom : body) {
+            if (atom.nullable) return true;
+        }
+        return false;
+    }
+    
+    // A head variable that occurs only in body atom `atom_idx`, or -1. For
+    // a nullable atom it is NULL exactly on the rows where that atom was
+    // padded, so "IS NOT NULL" on it recovers the matched rows.
+    int nullTestVariable(size_t atom_idx) const {
+        for (const auto& h : head) {
+            if (!h.is_variable) continue;
+            bool in_atom = false, elsewhere = false;
+            for (size_t a = 0; a < body.size(); ++a) {
+                for (const auto& t : body[a].terms) {
+                    if (t.id != h.id) continue;
+                    (a == atom_idx ? in_atom : elsewhere) = true;
+                }
+            }
+            if (in_atom && !elsewhere) return h.id;
+        }
+        return -1;
+    }
+    
     string toString() const {
         string result = name + "(";
         for (size_t i = 0; i < head.size(); ++i) {
             if (i > 0) result += ", ";
-            result += head[i].value;
+            result += symbols->name(head[i].id);
+        }
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            if (i > 0 || !head.empty()) result += ", ";
+            result += aggregates[i].toString(*symbols);
         }
         result += ") :- ";
         for (size_t i = 0; i < body.size(); ++i) {
             if (i > 0) result += ", ";
-            result += body[i].toString();
+            result += body[i].toString(*symbols);
+        }
+        for (const auto& c : comparisons) result += ", " + c.toString(*symbols);
+        for (const auto& [x, y] : on_equalities) {
+            result += ", ON " + symbols->name(x) + " = " + symbols->name(y);
+        }
+        if (!group_by.empty()) {
+            result += " GROUP BY ";
+            for (size_t i = 0; i < group_by.size(); ++i) {
+                if (i > 0) result += ", ";
+                result += symbols->name(group_by[i]);
+            }
         }
         return result;
     }
 };
 
-// Variable mapping for homomorphism
-using Mapping = map<string, string>;
+// Variable mapping for homomorphism: view variable ID -> query variable ID.
+// MCD mappings hold a handful of entries, so they are kept as a vector
+// sorted by key rather than a node-based map.
+struct Mapping {
+    vector<pair<int, int>> entries;
+    
+    // Image of `key`, or -1 if it is unmapped
+    int find(int key) const {
+        auto it = lower_bound(entries.begin(), entries.end(), 
+                              make_pair(key, INT_MIN));
+        if (it != entries.end() && it->first == key) return it->second;
+        return -1;
+    }
+    
+    void set(int key, int value) {
+        auto it = lower_bound(entries.begin(), entries.end(), 
+                              make_pair(key, INT_MIN));
+        if (it != entries.end() && it->first == key) {
+            it->second = value;
+        } else {
+            entries.insert(it, {key, value});
+        }
+    }
+    
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    vector<pair<int, int>>::const_iterator begin() const { return entries.begin(); }
+    vector<pair<int, int>>::const_iterator end() const { return entries.end(); }
+    
+    bool operator==(const Mapping& other) const {
+        return entries == other.entries;
+    }
+};
+
+// Dynamic-width bitset over query subgoal indices. Union, overlap and
+// full-coverage tests work a 64-bit word at a time, so queries wider than
+// 64 subgoals just use more words. Iterating yields the set bit indices.
+class DynamicBitset {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const DynamicBitset* b, int i) : bits(b), index(i) {}
+        int operator*() const { return index; }
+        const_iterator& operator++() {
+            index = bits->findNext(index);
+            return *this;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return index != other.index;
+        }
+    private:
+        const DynamicBitset* bits;
+        int index;
+    };
+    
+    DynamicBitset(size_t n = 0) : n_bits(n), words((n + 63) / 64, 0) {}
+    
+    size_t size() const { return n_bits; }
+    
+    void set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    
+    size_t count() const {
+        size_t c = 0;
+        for (uint64_t w : words) c += __builtin_popcountll(w);
+        return c;
+    }
+    
+    bool none() const {
+        for (uint64_t w : words) {
+            if (w) return false;
+        }
+        return true;
+    }
+    
+    bool all() const {
+        return count() == n_bits;
+    }
+    
+    bool intersects(const DynamicBitset& other) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            if (words[i] & other.words[i]) return true;
+        }
+        return false;
+    }
+    
+    DynamicBitset& operator|=(const DynamicBitset& other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] |= other.words[i];
+        return *this;
+    }
+    
+    DynamicBitset& operator&=(const DynamicBitset& other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= other.words[i];
+        return *this;
+    }
+    
+    void setAll() {
+        for (auto& w : words) w = ~uint64_t(0);
+        if (n_bits & 63) words.back() &= (uint64_t(1) << (n_bits & 63)) - 1;
+    }
+    
+    // Clear every bit that is set in `other`
+    DynamicBitset& subtract(const DynamicBitset& other) {
+        for (size_t i = 0; i < words.size(); ++i) words[i] &= ~other.words[i];
+        return *this;
+    }
+    
+    // Index of the first set bit after `i` (or of the first one at all when
+    // i is -1); -1 if there is none
+    int findNext(int i) const {
+        size_t start = i + 1;
+        if (start >= n_bits) return -1;
+        size_t w = start >> 6;
+        uint64_t word = words[w] & (~uint64_t(0) << (start & 63));
+        while (true) {
+            if (word) return (w << 6) + __builtin_ctzll(word);
+            if (++w == words.size()) return -1;
+            word = words[w];
+        }
+    }
+    
+    int findFirst() const { return findNext(-1); }
+    
+    // Index of the lowest clear bit, or -1 if all bits are set
+    int findFirstUnset() const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            if (~words[w]) {
+                size_t i = (w << 6) + __builtin_ctzll(~words[w]);
+                return i < n_bits ? int(i) : -1;
+            }
+        }
+        return -1;
+    }
+    
+    const_iterator begin() const { return const_iterator(this, findFirst()); }
+    const_iterator end() const { return const_iterator(this, -1); }
+    
+    bool operator==(const DynamicBitset& other) const {
+        return n_bits == other.n_bits && words == other.words;
+    }
+    
+private:
+    size_t n_bits;
+    vector<uint64_t> words;
+};
 
 // MCD: MiniCon Description
 struct MCD {
     int view_index;
-    set<int> covered_subgoals;  // Indices of query subgoals covered
+    DynamicBitset covered_subgoals; // Indices of query subgoals covered
     Mapping variable_mapping;         // View variables -> Query variables
-    set<string> distinguished_vars; // Head variables of query covered
+    set<int> distinguished_vars;    // Head variables of query covered
+    DynamicBitset view_atoms;       // View body atoms the mapping uses (only
+                                    // tracked for outer-join views)
     
-    string toString() const {
+    string toString(const SymbolTable& symbols) const {
         stringstream ss;
         ss << "View V" << view_index << " covers subgoals {";
         bool first = true;
@@ -117,7 +517,7 @@ struct MCD {
         first = true;
         for (const auto& [v_var, q_var] : variable_mapping) {
             if (!first) ss << ", ";
-            ss << v_var << "->" << q_var;
+            ss << symbols.name(v_var) << "->" << symbols.name(q_var);
             first = false;
         }
         ss << "}";
@@ -126,10 +526,34 @@ struct MCD {
 };
 
 // Query Rewriting: a combination of views
+// How a rewriting computes one query aggregate: `op` over column `var` of
+// view occurrence `occurrence` (COUNT(*) when var is -1), the column
+// multiplied by the view's count column `weight` when that is set
+struct AggregateTerm {
+    AggregateOp op;
+    int occurrence;
+    int var;
+    int weight = -1;
+};
+
 struct QueryRewriting {
     vector<int> view_indices;
     vector<Mapping> mappings;
-    set<int> covered_subgoals;
+    // View body atoms each occurrence uses; only filled when some
+    // occurrence is of an outer-join view
+    vector<DynamicBitset> view_atoms;
+    DynamicBitset covered_subgoals;
+    double cost = 0;            // Estimated join cost, set by the cost model
+    
+    // For aggregate queries: one term per query aggregate, and whether
+    // the view rows are grouped again (if not, each is one query group)
+    vector<AggregateTerm> aggregate_terms;
+    bool regroup = false;
+    
+    bool usesAtom(size_t occurrence, size_t atom) const {
+        return occurrence < view_atoms.size() && atom < view_atoms[occurrence].size() &&
+               view_atoms[occurrence].test(atom);
+    }
     
     string toString(const vector<ConjunctiveQuery>& views) const {
         stringstream ss;
@@ -146,36 +570,70 @@ struct QueryRewriting {
             const auto& view = views[view_indices[i]];
             for (size_t j = 0; j < view.head.size(); ++j) {
                 if (j > 0) ss << ", ";
-                const string& var = view.head[j].value;
-                if (mappings[i].find(var) != mappings[i].end()) {
-                    ss << mappings[i].at(var);
-                } else {
-                    ss << var;
-                }
+                int var = view.head[j].id;
+                int mapped = mappings[i].find(var);
+                ss << view.symbols->name(mapped != -1 ? mapped : var);
             }
             ss << ")";
         }
+        for (size_t k = 0; k < aggregate_terms.size(); ++k) {
+            ss << (k == 0 ? " | " : ", ") 
+               << aggregateSQL(k, views, *views[view_indices[0]].symbols);
+        }
         
         return ss.str();
     }
     
+    // Name occurrence i goes by in SQL: the view's name, or, for a view
+    // used more than once, the name with the occurrence's number among
+    // them (V2_1, V2_2, ...) as its alias
+    string occurrenceName(size_t i, const vector<ConjunctiveQuery>& views) const {
+        size_t before = 0, total = 0;
+        for (size_t j = 0; j < view_indices.size(); ++j) {
+            if (view_indices[j] != view_indices[i]) continue;
+            ++total;
+            if (j < i) ++before;
+        }
+        const string& name = views[view_indices[i]].name;
+        return total == 1 ? name : name + "_" + to_string(before + 1);
+    }
+    
+    // SQL expression of aggregate term k
+    string aggregateSQL(size_t k, const vector<ConjunctiveQuery>& views,
+                        const SymbolTable& symbols) const {
+        const AggregateTerm& term = aggregate_terms[k];
+        string view_name = occurrenceName(term.occurrence, views);
+        string column = term.var == -1 ? "*" : view_name + "." + symbols.name(term.var);
+        if (term.weight != -1) column += " * " + view_name + "." + symbols.name(term.weight);
+        if (!regroup) return column;
+        return string(Aggregate::opString(term.op)) + "(" + column + ")";
+    }
+    
     string toSQL(const vector<ConjunctiveQuery>& views, 
                       const ConjunctiveQuery& original_query) const {
         stringstream ss;
+        const SymbolTable& symbols = *original_query.symbols;
         ss << "SELECT ";
         
         // Build SELECT clause from original query head
         for (size_t i = 0; i < original_query.head.size(); ++i) {
             if (i > 0) ss << ", ";
-            ss << original_query.head[i].value;
+            ss << symbols.name(original_query.head[i].id);
+        }
+        for (size_t k = 0; k < aggregate_terms.size(); ++k) {
+            if (k > 0 || !original_query.head.empty()) ss << ", ";
+            ss << aggregateSQL(k, views, symbols) << " AS " 
+               << symbols.name(original_query.aggregates[k].output);
         }
         
         ss << " FROM ";
         
-        // Build FROM clause using view names
+        // Build FROM clause using view names, aliasing repeated views
         for (size_t i = 0; i < view_indices.size(); ++i) {
             if (i > 0) ss << ", ";
             ss << views[view_indices[i]].name;
+            string alias = occurrenceName(i, views);
+            if (alias != views[view_indices[i]].name) ss << " AS " << alias;
         }
         
         // Build WHERE clause from mappings (joins between views)
@@ -192,14 +650,54 @@ struct QueryRewriting {
                             } else {
                                 ss << " AND ";
                             }
-                            ss << views[view_indices[i]].name << "." << vi_var
-                               << " = " << views[view_indices[j]].name << "." << vj_var;
+                            ss << occurrenceName(i, views) << "." << symbols.name(vi_var)
+                               << " = " << occurrenceName(j, views) << "." << symbols.name(vj_var);
                         }
                     }
                 }
             }
         }
         
+        // Outer-join view occurrences keep only the rows where each nullable
+        // atom they use was matched
+        for (size_t i = 0; i < view_indices.size(); ++i) {
+            const auto& view = views[view_indices[i]];
+            for (size_t a = 0; a < view.body.size(); ++a) {
+                if (!view.body[a].nullable || !usesAtom(i, a)) continue;
+                ss << (first_where ? " WHERE " : " AND ");
+                first_where = false;
+                ss << occurrenceName(i, views) << "." << symbols.name(view.nullTestVariable(a)) 
+                   << " IS NOT NULL";
+            }
+        }
+        
+        // The query's range predicates, on the first view exporting each
+        // compared variable (a view that does not export it already
+        // guarantees the range)
+        for (const auto& c : original_query.comparisons) {
+            for (size_t i = 0; i < view_indices.size(); ++i) {
+                const auto& view = views[view_indices[i]];
+                int exported = -1;
+                for (const auto& t : view.head) {
+                    if (mappings[i].find(t.id) == c.var) exported = t.id;
+                }
+                if (exported == -1) continue;
+                ss << (first_where ? " WHERE " : " AND ");
+                first_where = false;
+                ss << setprecision(15) << occurrenceName(i, views) << "." << symbols.name(exported) 
+                   << " " << Comparison::opString(c.op) << " " << c.value;
+                break;
+            }
+        }
+        
+        if (regroup && !original_query.group_by.empty()) {
+            ss << " GROUP BY ";
+            for (size_t i = 0; i < original_query.group_by.size(); ++i) {
+                if (i > 0) ss << ", ";
+                ss << symbols.name(original_query.group_by[i]);
+            }
+        }
+        
         return ss.str();
     }
 };
@@ -236,6 +734,15 @@ public:
         return result;
     }
     
+    // Parse a whole string as a number (e.g. "1000", "-2.5")
+    static bool parseNumber(const string& s, double& value) {
+        string t = trim(s);
+        if (t.empty()) return false;
+        char* end = nullptr;
+        value = strtod(t.c_str(), &end);
+        return end == t.c_str() + t.size();
+    }
+    
     static vector<string> split(const string& s, const string& delim) {
         vector<string> result;
         size_t start = 0;
@@ -251,6 +758,169 @@ public:
     }
 };
 
+// ============================================================================
+// THREAD POOL
+// ============================================================================
+
+// Fixed set of worker threads reused across rewrite() calls. The calling
+// thread takes part as worker 0, so a pool of size 1 runs everything
+// inline. Only one parallelFor runs at a time.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned n_threads) {
+        if (n_threads == 0) n_threads = 1;
+        for (unsigned id = 1; id < n_threads; ++id) {
+            workers.emplace_back([this, id] { workerLoop(id); });
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(mu);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    unsigned size() const {
+        return workers.size() + 1;
+    }
+    
+    // Run body(i, worker) for every i in [0, n) and wait for completion.
+    // Indices are handed out dynamically, so uneven items balance out.
+    void parallelFor(size_t n, const function<void(size_t, unsigned)>& body) {
+        lock_guard<mutex> submit_lock(submit_mu);
+        {
+            lock_guard<mutex> lock(mu);
+            job = &body;
+            job_size = n;
+            next_index = 0;
+            busy = workers.size();
+            ++generation;
+        }
+        start_cv.notify_all();
+        runJob(body, n, 0);
+        
+        unique_lock<mutex> lock(mu);
+        done_cv.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+    
+private:
+    void runJob(const function<void(size_t, unsigned)>& body, size_t n, unsigned id) {
+        size_t i;
+        while ((i = next_index.fetch_add(1)) < n) {
+            body(i, id);
+        }
+    }
+    
+    void workerLoop(unsigned id) {
+        uint64_t seen = 0;
+        while (true) {
+            const function<void(size_t, unsigned)>* body;
+            size_t n;
+            {
+                unique_lock<mutex> lock(mu);
+                start_cv.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+                body = job;
+                n = job_size;
+            }
+            runJob(*body, n, id);
+            {
+                lock_guard<mutex> lock(mu);
+                --busy;
+            }
+            done_cv.notify_one();
+        }
+    }
+    
+    vector<thread> workers;
+    mutex submit_mu;
+    mutex mu;
+    condition_variable start_cv;
+    condition_variable done_cv;
+    const function<void(size_t, unsigned)>* job = nullptr;
+    size_t job_size = 0;
+    atomic<size_t> next_index{0};
+    size_t busy = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
+
+// Work-stealing scheduler running on a ThreadPool's threads. Every worker
+// owns a deque: it pushes and pops its own tasks at the back and, once it
+// runs dry, steals the oldest task (typically the largest subtree) from
+// the front of another worker's deque. Tasks may spawn further tasks;
+// run() returns when all of them have finished.
+class WorkStealingScheduler {
+public:
+    using Task = function<void(unsigned)>;
+    
+    explicit WorkStealingScheduler(ThreadPool& p) 
+        : pool(p), queues(p.size()) {}
+    
+    void spawn(unsigned worker, Task task) {
+        pending.fetch_add(1);
+        lock_guard<mutex> lock(queues[worker].mu);
+        queues[worker].tasks.push_back(move(task));
+    }
+    
+    void run(Task root) {
+        spawn(0, move(root));
+        pool.parallelFor(pool.size(), [this](size_t, unsigned worker) {
+            workLoop(worker);
+        });
+    }
+    
+private:
+    struct WorkQueue {
+        mutex mu;
+        deque<Task> tasks;
+    };
+    
+    bool popLocal(unsigned worker, Task& task) {
+        lock_guard<mutex> lock(queues[worker].mu);
+        if (queues[worker].tasks.empty()) return false;
+        task = move(queues[worker].tasks.back());
+        queues[worker].tasks.pop_back();
+        return true;
+    }
+    
+    bool steal(unsigned worker, Task& task) {
+        for (size_t k = 1; k < queues.size(); ++k) {
+            WorkQueue& victim = queues[(worker + k) % queues.size()];
+            lock_guard<mutex> lock(victim.mu);
+            if (victim.tasks.empty()) continue;
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+    
+    void workLoop(unsigned worker) {
+        Task task;
+        while (pending.load() > 0) {
+            if (popLocal(worker, task) || steal(worker, task)) {
+                task(worker);
+                pending.fetch_sub(1);
+            } else {
+                this_thread::yield();
+            }
+        }
+    }
+    
+    ThreadPool& pool;
+    vector<WorkQueue> queues;
+    atomic<size_t> pending{0};
+};
+
 // ============================================================================
 // SQL TO CONJUNCTIVE QUERY CONVERTER
 // ============================================================================
@@ -260,77 +930,93 @@ private:
     struct SQLParsed {
         vector<string> select_attrs;
         vector<string> tables;
-        vector<pair<string, string>> joins; // pairs of qualified names (left, right)
+        // Qualified names (left, right), and whether the equality is an
+        // outer join's ON condition rather than a filter
+        vector<tuple<string, string, bool>> joins;
         map<string, string> table_aliases;  // alias -> base table
+        // Column op constant, and whether it is from an outer join's ON
+        vector<tuple<string, CompareOp, double, bool>> comparisons;
+        set<string> nullable_tables;        // Null-supplied side of an outer join
+        int outer_joins = 0;
+        // SELECT aggregates: op, argument column ("*" for COUNT(*)), alias
+        vector<tuple<AggregateOp, string, string>> aggregates;
+        vector<string> group_by;
+        string unsupported;                 // Why the statement cannot be modeled
     };
 
     // Toggle debug output
     static constexpr bool DEBUG = true;
 
+    // Interner shared by every query and view this converter produces
+    shared_ptr<SymbolTable> symbols;
+    
+    // Known table schemas, keyed by lower-cased table name. A known table
+    // gets an atom over all of its columns in schema order, so queries and
+    // views agree on arity, and unqualified columns resolve to it.
+    map<string, vector<string>> schema;
+
     // Helper: lower-case & trim already exist in Utils; reuse them as needed.
 
     // Parse a very small subset of SQL (SELECT ... FROM ... WHERE ... AND ...)
-    SQLParsed parseSQL(const string& sql) {
+    SQLParsed parseSQL(const string& statement) {
         SQLParsed parsed;
+        string sql = Utils::trim(statement);
+        if (!sql.empty() && sql.back() == ';') sql.pop_back();
         string sql_lower = Utils::toLower(sql);
 
-        // Find SELECT, FROM, WHERE positions
+        // Find SELECT, FROM, WHERE, GROUP BY positions; each clause runs
+        // to the next one present (ORDER BY is ignored)
         size_t select_pos = sql_lower.find("select");
         size_t from_pos   = sql_lower.find("from");
         size_t where_pos  = sql_lower.find("where");
+        size_t group_pos  = sql_lower.find("group by");
+        size_t order_pos  = sql_lower.find("order by");
+        if (sql_lower.find("having") != string::npos) parsed.unsupported = "HAVING";
+        auto clauseEnd = [&](size_t begin) {
+            size_t end = sql.size();
+            for (size_t pos : {where_pos, group_pos, order_pos}) {
+                if (pos != string::npos && pos > begin) end = min(end, pos);
+            }
+            return end;
+        };
 
         if (select_pos == string::npos || from_pos == string::npos) {
             cerr << "Invalid SQL: missing SELECT or FROM\n";
             return parsed;
         }
 
-        // Parse SELECT clause
+        // Parse SELECT clause: plain columns and aggregates
         string select_clause = sql.substr(select_pos + 6, from_pos - select_pos - 6);
-        parsed.select_attrs = Utils::split(select_clause, ',');
+        for (const auto& item : Utils::split(select_clause, ',')) {
+            if (!parseAggregate(item, parsed)) parsed.select_attrs.push_back(item);
+        }
 
         // Parse FROM clause
-        string from_clause;
-        if (where_pos != string::npos) {
-            from_clause = sql.substr(from_pos + 4, where_pos - from_pos - 4);
-        } else {
-            from_clause = sql.substr(from_pos + 4);
-        }
+        string from_clause = sql.substr(from_pos + 4, clauseEnd(from_pos) - from_pos - 4);
 
+        replace_if(from_clause.begin(), from_clause.end(), 
+                   [](char c) { return isspace((unsigned char)c); }, ' ');
         auto table_parts = Utils::split(from_clause, ',');
         for (const auto& part : table_parts) {
-            auto tokens = Utils::split(part, ' ');
-            if (tokens.empty()) continue;
-            // tokens[0] is table name, optional last token is alias
-            string base = tokens[0];
-            string alias;
-            if (tokens.size() >= 2) {
-                // handle "AS"
-                if (tokens.size() >= 3 && Utils::toLower(tokens[tokens.size()-2]) == "as") {
-                    alias = tokens.back();
-                } else {
-                    alias = tokens.back();
-                }
-            }
-            // store base and alias relationship
-            parsed.tables.push_back(base);
-            if (!alias.empty()) {
-                parsed.table_aliases[alias] = base;
-            }
+            parseJoinChain(Utils::split(part, ' '), parsed);
+        }
+        if (parsed.outer_joins > 1) {
+            parsed.unsupported = "more than one outer join";
         }
 
-        // Parse WHERE clause: only equality predicates combined with AND
+        // Parse WHERE clause: equalities between columns are joins;
+        // comparisons of a column with a number become range predicates
         if (where_pos != string::npos) {
-            string where_clause = sql.substr(where_pos + 5);
-            auto predicates = Utils::split(where_clause, "AND");
-            for (const auto& pred : predicates) {
-                size_t eq_pos = pred.find('=');
-                if (eq_pos != string::npos) {
-                    string left = Utils::trim(pred.substr(0, eq_pos));
-                    string right = Utils::trim(pred.substr(eq_pos + 1));
-                    parsed.joins.push_back({left, right});
-                }
+            string where_clause = sql.substr(where_pos + 5, clauseEnd(where_pos) - where_pos - 5);
+            for (const auto& pred : splitPredicates(where_clause)) {
+                parsePredicate(pred, parsed);
             }
         }
+        
+        if (group_pos != string::npos) {
+            string group_clause = sql.substr(group_pos + 8, clauseEnd(group_pos) - group_pos - 8);
+            parsed.group_by = Utils::split(group_clause, ',');
+        }
 
         // Normalize: replace any alias mention in parsed.tables with base table name
         for (auto &t : parsed.tables) {
@@ -348,57 +1034,311 @@ private:
             cerr << " Select attrs:\n";
             for (auto &a : parsed.select_attrs) cerr << "  " << a << "\n";
             cerr << " Joins:\n";
-            for (auto &j : parsed.joins) cerr << "  " << j.first << " = " << j.second << "\n";
+            for (auto &[left, right, on] : parsed.joins) {
+                cerr << "  " << left << " = " << right << (on ? " (ON)" : "") << "\n";
+            }
+            cerr << " Comparisons:\n";
+            for (auto &[col, op, value, on] : parsed.comparisons) {
+                cerr << "  " << col << " " << Comparison::opString(op) << " " << value 
+                     << (on ? " (ON)" : "") << "\n";
+            }
+            for (auto &[op, arg, alias] : parsed.aggregates) {
+                cerr << " Aggregate: " << Aggregate::opString(op) << "(" << arg << ")"
+                     << (alias.empty() ? "" : " AS " + alias) << "\n";
+            }
+            if (!parsed.group_by.empty()) {
+                cerr << " Group by:";
+                for (auto &g : parsed.group_by) cerr << " " << g;
+                cerr << "\n";
+            }
+            if (!parsed.nullable_tables.empty()) {
+                cerr << " Nullable:";
+                for (auto &t : parsed.nullable_tables) cerr << " " << t;
+                cerr << "\n";
+            }
         }
 
         return parsed;
     }
 
-    // Extract table and attribute from qualified name (e.g., "customer.name" -> {"customer", "name"})
-    pair<string, string> splitQualifiedName(const string& name) {
-        size_t dot_pos = name.find('.');
-        if (dot_pos != string::npos) {
-            string left = Utils::trim(name.substr(0, dot_pos));
-            string right = Utils::trim(name.substr(dot_pos + 1));
-            return {left, right};
+    // Recognize "OP(column) [AS alias]" for SUM, COUNT, MIN and MAX (and
+    // COUNT(*)); other aggregates and DISTINCT arguments are recorded as
+    // unsupported. Returns false for a plain column.
+    static bool parseAggregate(const string& item, SQLParsed& parsed) {
+        size_t open = item.find('(');
+        size_t close = item.rfind(')');
+        if (open == string::npos || close == string::npos || close < open) return false;
+        static const map<string, AggregateOp> functions = {
+            {"sum", AggregateOp::Sum}, {"count", AggregateOp::Count},
+            {"min", AggregateOp::Min}, {"max", AggregateOp::Max}
+        };
+        string function = Utils::toLower(Utils::trim(item.substr(0, open)));
+        string arg = Utils::trim(item.substr(open + 1, close - open - 1));
+        auto it = functions.find(function);
+        if (it == functions.end() || Utils::toLower(arg).rfind("distinct ", 0) == 0) {
+            parsed.unsupported = "aggregate " + Utils::trim(item);
+            return true;
         }
-        return {"", Utils::trim(name)};
+        if (arg == "*" && it->second != AggregateOp::Count) {
+            parsed.unsupported = "aggregate " + Utils::trim(item);
+            return true;
+        }
+        auto alias = Utils::split(item.substr(close + 1), ' ');
+        if (!alias.empty() && Utils::toLower(alias[0]) == "as") alias.erase(alias.begin());
+        parsed.aggregates.emplace_back(it->second, arg, alias.empty() ? "" : alias[0]);
+        return true;
     }
 
-    // Generate variable name for a canonical attribute key "Table.attr"
-    // Generate variable name for a canonical attribute key "Table.attr"
-    string generateVarName(const string& canonical_attr, map<string, string>& attr_to_var, int& var_counter) {
-        auto it = attr_to_var.find(canonical_attr);
-        if (it != attr_to_var.end()) return it->second;
-        // Make a deterministic variable name from canonical_attr, e.g., "Customer.name" -> "Customer_name"
-        string var = canonical_attr;
-        for (char &c : var) {
-            if (c == '.') c = '_';
-            // optionally sanitize other characters if needed
-        }
-        // ensure uniqueness (rare): if var already used as a value, append a counter
-        bool used = false;
-        for (const auto &kv : attr_to_var) {
-            if (kv.second == var) {
-                used = true;
-                break;
+    // One comma-separated FROM item: a table with optional alias, followed
+    // by any number of "[INNER | CROSS | LEFT | RIGHT | FULL] [OUTER] JOIN
+    // table [alias] [ON predicates]" clauses. Tables an outer join may pad
+    // with NULLs are recorded as nullable. The null-supplied side must be
+    // a single table; a RIGHT or FULL join after other joins is rejected.
+    static void parseJoinChain(const vector<string>& tokens, SQLParsed& parsed) {
+        static const set<string> join_words = {"join", "inner", "cross", "left", "right", "full"};
+        auto word = [&](size_t i) { 
+            return i < tokens.size() ? Utils::toLower(tokens[i]) : string(); 
+        };
+        size_t i = 0;
+        vector<string> chain;   // Tables of this item so far
+        auto readTable = [&]() {
+            if (i >= tokens.size()) return;
+            string base = tokens[i++];
+            if (word(i) == "as") ++i;
+            if (i < tokens.size() && !join_words.count(word(i)) && word(i) != "on") {
+                parsed.table_aliases[tokens[i++]] = base;
             }
-        }
-        if (used) {
+            parsed.tables.push_back(base);
+            chain.push_back(base);
+        };
+        
+        readTable();
+        while (i < tokens.size()) {
+            string kind = word(i++);
+            if (!join_words.count(kind)) continue;  // Stray token
+            if (word(i) == "outer") ++i;
+            if (kind != "join" && word(i) == "join") ++i;
+            bool outer = kind == "left" || kind == "right" || kind == "full";
+            size_t preserved = chain.size();
+            readTable();
+            if (outer) {
+                ++parsed.outer_joins;
+                if (kind != "left" && preserved > 1) {
+                    parsed.unsupported = "RIGHT/FULL join of a multi-table left side";
+                }
+                if (kind != "right") parsed.nullable_tables.insert(chain.back());
+                if (kind != "left") parsed.nullable_tables.insert(chain.front());
+            }
+            if (word(i) != "on") continue;
+            ++i;
+            string condition;
+            while (i < tokens.size() && !join_words.count(word(i))) {
+                condition += tokens[i++] + " ";
+            }
+            for (const auto& pred : splitPredicates(condition)) {
+                parsePredicate(pred, parsed, outer);
+            }
+        }
+    }
+
+    // Split a WHERE clause on AND in any case, keeping the AND of
+    // "x BETWEEN a AND b" inside its predicate
+    static vector<string> splitPredicates(const string& where_clause) {
+        vector<string> predicates;
+        string lower = Utils::toLower(where_clause);
+        auto isWordAt = [&](size_t pos, const string& word) {
+            if (lower.compare(pos, word.size(), word) != 0) return false;
+            bool before = pos == 0 || !isalnum((unsigned char)lower[pos - 1]);
+            size_t after = pos + word.size();
+            return before && (after >= lower.size() || !isalnum((unsigned char)lower[after]));
+        };
+        size_t start = 0;
+        bool in_between = false;
+        for (size_t pos = 0; pos < lower.size(); ++pos) {
+            if (isWordAt(pos, "between")) {
+                in_between = true;
+            } else if (isWordAt(pos, "and")) {
+                if (in_between) {
+                    in_between = false;
+                    continue;
+                }
+                predicates.push_back(Utils::trim(where_clause.substr(start, pos - start)));
+                start = pos + 3;
+            }
+        }
+        predicates.push_back(Utils::trim(where_clause.substr(start)));
+        predicates.erase(remove(predicates.begin(), predicates.end(), ""), predicates.end());
+        return predicates;
+    }
+
+    // Classify one predicate as a join or range predicate(s). Comparisons
+    // between two columns other than equality are not supported and are
+    // dropped. `outer_on` marks a predicate of an outer join's ON clause.
+    static void parsePredicate(const string& pred, SQLParsed& parsed, 
+                               bool outer_on = false) {
+        string lower = Utils::toLower(pred);
+        size_t between_pos = lower.find(" between ");
+        if (between_pos != string::npos) {
+            string column = Utils::trim(pred.substr(0, between_pos));
+            string bounds = pred.substr(between_pos + 9);
+            size_t and_pos = Utils::toLower(bounds).find(" and ");
+            double lo, hi;
+            if (and_pos != string::npos &&
+                Utils::parseNumber(bounds.substr(0, and_pos), lo) &&
+                Utils::parseNumber(bounds.substr(and_pos + 5), hi)) {
+                parsed.comparisons.emplace_back(column, CompareOp::Ge, lo, outer_on);
+                parsed.comparisons.emplace_back(column, CompareOp::Le, hi, outer_on);
+            }
+            return;
+        }
+        
+        // An inequality is no interval. Read as "=" or dropped it would make
+        // a view look more general than it is, so the statement is refused.
+        for (const char* op_text : {"!=", "<>"}) {
+            if (pred.find(op_text) != string::npos) {
+                parsed.unsupported = "inequality " + Utils::trim(pred);
+                return;
+            }
+        }
+        
+        // Two-character operators first so "<=" is not read as "<"
+        static const vector<pair<string, CompareOp>> operators = {
+            {"<=", CompareOp::Le}, {">=", CompareOp::Ge},
+            {"<", CompareOp::Lt}, {">", CompareOp::Gt}, {"=", CompareOp::Eq}
+        };
+        for (const auto& [op_text, op] : operators) {
+            size_t op_pos = pred.find(op_text);
+            if (op_pos == string::npos) continue;
+            string left = Utils::trim(pred.substr(0, op_pos));
+            string right = Utils::trim(pred.substr(op_pos + op_text.size()));
+            double value;
+            if (Utils::parseNumber(right, value)) {
+                parsed.comparisons.emplace_back(left, op, value, outer_on);
+            } else if (Utils::parseNumber(left, value)) {
+                // "1000 > x" is "x < 1000"
+                static const map<CompareOp, CompareOp> flipped = {
+                    {CompareOp::Lt, CompareOp::Gt}, {CompareOp::Le, CompareOp::Ge},
+                    {CompareOp::Gt, CompareOp::Lt}, {CompareOp::Ge, CompareOp::Le},
+                    {CompareOp::Eq, CompareOp::Eq}
+                };
+                parsed.comparisons.emplace_back(right, flipped.at(op), value, outer_on);
+            } else if (op == CompareOp::Eq) {
+                parsed.joins.emplace_back(left, right, outer_on);
+            }
+            return;
+        }
+    }
+
+    // Extract table and attribute from qualified name (e.g., "customer.name" -> {"customer", "name"})
+    pair<string, string> splitQualifiedName(const string& name) {
+        size_t dot_pos = name.find('.');
+        if (dot_pos != string::npos) {
+            string left = Utils::trim(name.substr(0, dot_pos));
+            string right = Utils::trim(name.substr(dot_pos + 1));
+            return {left, right};
+        }
+        return {"", Utils::trim(name)};
+    }
+
+    // Canonical key "BaseTable.attr" of a column mention. Aliases resolve
+    // to their base table; an unqualified column resolves to the FROM
+    // table whose schema has it, or stays bare if no schema knows it.
+    string canonicalKey(const string& column, SQLParsed& parsed) {
+        auto [tbl, attr_name] = splitQualifiedName(column);
+        if (!tbl.empty() && parsed.table_aliases.find(tbl) != parsed.table_aliases.end()) {
+            tbl = parsed.table_aliases[tbl];
+        }
+        if (tbl.empty()) {
+            for (const auto& table : parsed.tables) {
+                auto it = schema.find(Utils::toLower(table));
+                if (it == schema.end()) continue;
+                if (find(it->second.begin(), it->second.end(), attr_name) != it->second.end()) {
+                    tbl = table;
+                    break;
+                }
+            }
+        }
+        return !tbl.empty() ? tbl + "." + attr_name : attr_name;
+    }
+
+    // The table of canonical key "Table.attr" is no longer null-supplied
+    static void rejectNulls(const string& canonical_key, SQLParsed& parsed) {
+        size_t dot = canonical_key.find('.');
+        if (dot != string::npos) parsed.nullable_tables.erase(canonical_key.substr(0, dot));
+    }
+
+    // Generate variable name for a canonical attribute key "Table.attr"
+    string generateVarName(const string& canonical_attr, map<string, string>& attr_to_var, int& var_counter) {
+        auto it = attr_to_var.find(canonical_attr);
+        if (it != attr_to_var.end()) return it->second;
+        // Make a deterministic variable name from canonical_attr, e.g., "Customer.name" -> "Customer_name"
+        string var = canonical_attr;
+        for (char &c : var) {
+            if (c == '.') c = '_';
+            // optionally sanitize other characters if needed
+        }
+        // ensure uniqueness (rare): if var already used as a value, append a counter
+        bool used = false;
+        for (const auto &kv : attr_to_var) {
+            if (kv.second == var) {
+                used = true;
+                break;
+            }
+        }
+        if (used) {
             var += "_" + to_string(var_counter++);
         }
         attr_to_var[canonical_attr] = var;
         return var;
     }
 public:
+    SQLToConjunctiveQuery(shared_ptr<SymbolTable> table = make_shared<SymbolTable>())
+        : symbols(table) {}
+
+    shared_ptr<SymbolTable> getSymbols() const {
+        return symbols;
+    }
+
+    void addTable(const string& table, const vector<string>& columns) {
+        schema[Utils::toLower(table)] = columns;
+    }
+
+    // The TPC-H tables used by the examples and test cases
+    void addTPCHSchema() {
+        addTable("customer", {"c_custkey", "c_name", "c_address", "c_nationkey", 
+                              "c_phone", "c_acctbal", "c_mktsegment", "c_comment"});
+        addTable("orders", {"o_orderkey", "o_custkey", "o_orderstatus", "o_totalprice", 
+                            "o_orderdate", "o_orderpriority", "o_clerk", 
+                            "o_shippriority", "o_comment"});
+        addTable("lineitem", {"l_orderkey", "l_partkey", "l_suppkey", "l_linenumber", 
+                              "l_quantity", "l_extendedprice", "l_discount", "l_tax", 
+                              "l_returnflag", "l_linestatus", "l_shipdate", 
+                              "l_commitdate", "l_receiptdate", "l_shipinstruct", 
+                              "l_shipmode", "l_comment"});
+        addTable("part", {"p_partkey", "p_name", "p_mfgr", "p_brand", "p_type", 
+                          "p_size", "p_container", "p_retailprice", "p_comment"});
+        addTable("supplier", {"s_suppkey", "s_name", "s_address", "s_nationkey", 
+                              "s_phone", "s_acctbal", "s_comment"});
+        addTable("partsupp", {"ps_partkey", "ps_suppkey", "ps_availqty", 
+                              "ps_supplycost", "ps_comment"});
+        addTable("nation", {"n_nationkey", "n_name", "n_regionkey", "n_comment"});
+        addTable("region", {"r_regionkey", "r_name", "r_comment"});
+    }
+
     ConjunctiveQuery convert(const string& sql, const string& query_name = "Q") {
         ConjunctiveQuery cq(query_name);
+        cq.symbols = symbols;
         SQLParsed parsed = parseSQL(sql);
 
         // If parsing failed or no tables, return an empty CQ
         if (parsed.tables.empty()) {
             return cq;
         }
+        if (!parsed.unsupported.empty()) {
+            cerr << "SQLToConjunctiveQuery: " << query_name << " not modeled ("
+                 << parsed.unsupported << ")\n";
+            return cq;
+        }
 
         // --- PATCH A: normalize aliases to base table names (ensure parsed.tables contain base names)
         // Already applied in parseSQL but double-check joins/aliases usage below.
@@ -407,65 +1347,87 @@ public:
         map<string, string> attr_to_var;
         int var_counter = 1;
 
+        // A filter on a null-supplied column throws the padded rows away,
+        // which makes its outer join an inner one
+        for (const auto& [left, right, outer_on] : parsed.joins) {
+            if (outer_on) continue;
+            rejectNulls(canonicalKey(left, parsed), parsed);
+            rejectNulls(canonicalKey(right, parsed), parsed);
+        }
+        for (const auto& cmp : parsed.comparisons) {
+            if (!get<3>(cmp)) rejectNulls(canonicalKey(get<0>(cmp), parsed), parsed);
+        }
+        bool outer = !parsed.nullable_tables.empty();
+
         // Step 1: Build mapping for SELECT attributes (head) using canonical keys
+        // (head terms are interned after Step 2, which may rename them)
         for (const auto& sel_attr : parsed.select_attrs) {
-            auto [tbl, attr_name] = splitQualifiedName(sel_attr);
-            // resolve alias if present
-            if (!tbl.empty() && parsed.table_aliases.find(tbl) != parsed.table_aliases.end()) {
-                tbl = parsed.table_aliases[tbl];
-            }
-            string canonical_key;
-            if (!tbl.empty()) canonical_key = tbl + "." + attr_name;
-            else canonical_key = attr_name; // fallback
-
-            string var = generateVarName(canonical_key, attr_to_var, var_counter);
-            cq.head.push_back(Term(var, true));
+            generateVarName(canonicalKey(sel_attr, parsed), attr_to_var, var_counter);
         }
 
         // Step 2: Process joins -> ensure both sides map to same canonical variable
-        for (const auto& pr : parsed.joins) {
-            const string& left = pr.first;
-            const string& right = pr.second;
-
-            auto [left_table, left_attr] = splitQualifiedName(left);
-            auto [right_table, right_attr] = splitQualifiedName(right);
-
-            // Resolve aliases
-            if (!left_table.empty() && parsed.table_aliases.find(left_table) != parsed.table_aliases.end())
-                left_table = parsed.table_aliases[left_table];
-            if (!right_table.empty() && parsed.table_aliases.find(right_table) != parsed.table_aliases.end())
-                right_table = parsed.table_aliases[right_table];
-
-            // If either side lacks explicit table (unqualified), we don't change it
-            string left_key  = (!left_table.empty())  ? left_table  + "." + left_attr  : left_attr;
-            string right_key = (!right_table.empty()) ? right_table + "." + right_attr : right_attr;
+        // (outer join ON equalities keep both variables, see on_equalities)
+        vector<pair<string, string>> on_keys;
+        for (const auto& [left, right, outer_on] : parsed.joins) {
+            // Unqualified columns no schema knows are left bare
+            string left_key  = canonicalKey(left, parsed);
+            string right_key = canonicalKey(right, parsed);
+            if (outer_on && outer) {
+                generateVarName(left_key, attr_to_var, var_counter);
+                generateVarName(right_key, attr_to_var, var_counter);
+                on_keys.push_back({left_key, right_key});
+                continue;
+            }
 
             // Pick a canonical key deterministically (lexicographic or left_key)
             string canonical_key = left_key; // left as canonical
             // If neither key is present in attr_to_var yet, create canonical var.
             string join_var = generateVarName(canonical_key, attr_to_var, var_counter);
 
-            // Force both sides to refer to the same variable
+            // Force both sides, and every column already joined to the
+            // right side, to refer to the same variable
+            auto right_it = attr_to_var.find(right_key);
+            if (right_it != attr_to_var.end() && right_it->second != join_var) {
+                string old_var = right_it->second;
+                for (auto& kv : attr_to_var) {
+                    if (kv.second == old_var) kv.second = join_var;
+                }
+            }
             attr_to_var[left_key] = join_var;
             attr_to_var[right_key] = join_var;
         }
+        for (const auto& sel_attr : parsed.select_attrs) {
+            string var = attr_to_var[canonicalKey(sel_attr, parsed)];
+            cq.head.push_back(Term(symbols->intern(var), true));
+        }
 
         // Step 3: For any remaining select attributes or implied attributes that do not yet have a var, assign one
         // This helps when select attributes aren't part of any join
+        // Compared columns need a variable too, so the atom exposes them
         for (const auto& sel_attr : parsed.select_attrs) {
-            auto [tbl, attr_name] = splitQualifiedName(sel_attr);
-            if (!tbl.empty() && parsed.table_aliases.find(tbl) != parsed.table_aliases.end())
-                tbl = parsed.table_aliases[tbl];
-            string canonical_key = (!tbl.empty()) ? tbl + "." + attr_name : attr_name;
+            string canonical_key = canonicalKey(sel_attr, parsed);
             if (attr_to_var.find(canonical_key) == attr_to_var.end()) {
                 generateVarName(canonical_key, attr_to_var, var_counter);
             }
         }
+        vector<string> compared_keys;
+        for (const auto& cmp : parsed.comparisons) {
+            compared_keys.push_back(canonicalKey(get<0>(cmp), parsed));
+            generateVarName(compared_keys.back(), attr_to_var, var_counter);
+        }
+        // Likewise aggregated and grouping columns
+        for (const auto& [op, arg, alias] : parsed.aggregates) {
+            if (arg != "*") generateVarName(canonicalKey(arg, parsed), attr_to_var, var_counter);
+        }
+        for (const auto& column : parsed.group_by) {
+            generateVarName(canonicalKey(column, parsed), attr_to_var, var_counter);
+        }
 
         // Step 4: Create atoms for each table deterministically using canonical attr_to_var keys
         for (const auto& table : parsed.tables) {
             string resolved_table = table;
-            Atom atom(resolved_table);
+            Atom atom(symbols->intern(resolved_table));
+            atom.nullable = parsed.nullable_tables.count(resolved_table) > 0;
 
             // Collect canonical attributes that belong to this table (prefix "Table.")
             vector<string> attrs_for_table;
@@ -480,13 +1442,31 @@ public:
                 }
             }
 
-            // Sort to keep deterministic order across query and views
+            // Sort to keep deterministic order across query and views; a
+            // table with a known schema lists every schema column first, in
+            // schema order, with a variable of its own if the SQL never
+            // mentions it
             sort(attrs_for_table.begin(), attrs_for_table.end());
+            auto known = schema.find(Utils::toLower(resolved_table));
+            if (known != schema.end()) {
+                vector<string> ordered;
+                for (const auto& column : known->second) {
+                    string canon = resolved_table + "." + column;
+                    generateVarName(canon, attr_to_var, var_counter);
+                    ordered.push_back(canon);
+                }
+                for (const auto& canon : attrs_for_table) {
+                    if (find(ordered.begin(), ordered.end(), canon) == ordered.end()) {
+                        ordered.push_back(canon);
+                    }
+                }
+                attrs_for_table = move(ordered);
+            }
 
             // Add terms (variables) to atom in that deterministic order
             for (const auto& canon : attrs_for_table) {
                 string var = attr_to_var[canon];
-                atom.addTerm(Term(var, true));
+                atom.addTerm(Term(symbols->intern(var), true));
             }
 
             // If the table had no canonical attributes but it was listed in FROM, we add a single placeholder
@@ -495,12 +1475,42 @@ public:
                 // create a placeholder var that is unique to this table in this query
                 string placeholder_canon = resolved_table + "._placeholder";
                 string pvar = generateVarName(placeholder_canon, attr_to_var, var_counter);
-                atom.addTerm(Term(pvar, true));
+                atom.addTerm(Term(symbols->intern(pvar), true));
             }
 
             cq.body.push_back(atom);
         }
 
+        // Step 5: Range predicates on the variables of their columns (ON
+        // predicates are plain filters once no outer join is left)
+        for (size_t i = 0; i < parsed.comparisons.size(); ++i) {
+            const auto& [column, op, value, outer_on] = parsed.comparisons[i];
+            int var = symbols->intern(attr_to_var[compared_keys[i]]);
+            cq.comparisons.push_back({var, op, value, outer_on && outer});
+        }
+        for (const auto& [left_key, right_key] : on_keys) {
+            cq.on_equalities.push_back({symbols->intern(attr_to_var[left_key]), 
+                                        symbols->intern(attr_to_var[right_key])});
+        }
+
+        // Step 6: Grouping and aggregates. An unnamed aggregate is named
+        // after its function and argument, e.g. sum_Customer_c_acctbal.
+        for (const auto& column : parsed.group_by) {
+            int var = symbols->intern(attr_to_var[canonicalKey(column, parsed)]);
+            if (find(cq.group_by.begin(), cq.group_by.end(), var) == cq.group_by.end()) {
+                cq.group_by.push_back(var);
+            }
+        }
+        for (const auto& [op, arg, alias] : parsed.aggregates) {
+            int var = arg == "*" ? -1 : symbols->intern(attr_to_var[canonicalKey(arg, parsed)]);
+            string output = alias;
+            if (output.empty()) {
+                output = Utils::toLower(Aggregate::opString(op)) + "_" + 
+                         (var == -1 ? string("all") : symbols->name(var));
+            }
+            cq.aggregates.push_back({op, var, symbols->intern(output)});
+        }
+
         // DEBUG dumps to help diagnose mismatches if rewrites are still 0
         if (DEBUG) {
             cerr << "DEBUG: attr_to_var for SQL (" << query_name << "):\n";
@@ -509,8 +1519,8 @@ public:
             }
             cerr << "DEBUG: Constructed atoms for " << query_name << ":\n";
             for (const auto &atom : cq.body) {
-                cerr << "  " << atom.toString() << "  terms:";
-                for (const auto &t : atom.terms) cerr << " " << t.value;
+                cerr << "  " << atom.toString(*symbols) << "  terms:";
+                for (const auto &t : atom.terms) cerr << " " << symbols->name(t.id);
                 cerr << "\n";
             }
         }
@@ -520,327 +1530,4555 @@ public:
 };
 
 // ============================================================================
-// MINICON ALGORITHM
+// QUERY FINGERPRINTS AND REWRITING CACHE
 // ============================================================================
 
-class MiniCon {
-public:
-    ConjunctiveQuery query;
-    vector<ConjunctiveQuery> views;
-    vector<MCD> mcds;
+// Canonical form of a conjunctive query. The fingerprint encodes the body
+// with atoms in a canonical order and variables renamed v0, v1, ... by
+// first occurrence, and the head as a set, so it does not depend on
+// variable names, atom order or SELECT column order. It is the complete
+// encoding rather than a hash: equal fingerprints always mean isomorphic
+// queries. Atoms that colour refinement cannot tell apart keep their
+// original relative order, so such symmetric queries may occasionally
+// get two fingerprints (a cache miss, never a wrong hit).
+struct CanonicalQuery {
+    string fingerprint;
+    vector<int> atom_order;     // Canonical position -> original atom index
+    vector<int> variables;      // Canonical variable number -> variable ID
+};
+
+CanonicalQuery canonicalize(const ConjunctiveQuery& q) {
+    const SymbolTable& symbols = *q.symbols;
+    set<int> head_vars = q.getHeadVariables();
     
-    // Check if a mapping is consistent (no conflicts)
-    bool isConsistentMapping(const Mapping& m1, const Mapping& m2) {
-        for (const auto& [key, val] : m1) {
-            if (m2.find(key) != m2.end() && m2.at(key) != val) {
-                return false;
+    // Colour refinement: a variable's colour starts as head/non-head and is
+    // refined by the (relation, position, atom colour) of its occurrences
+    // Range-restricted variables start in a colour of their range, since
+    // queries differing only in ranges must not share a fingerprint
+    map<int, Interval> ranges = q.intervals();
+    map<string, int> initial_colors;
+    map<int, int> color;
+    for (int v : q.getVariables()) {
+        string key = to_string(head_vars.count(v));
+        auto range = ranges.find(v);
+        if (range != ranges.end()) key += range->second.toString();
+        color[v] = initial_colors.emplace(key, initial_colors.size()).first->second;
+    }
+    vector<string> atom_sig(q.body.size());
+    size_t n_classes = 0;
+    for (size_t round = 0; round <= color.size(); ++round) {
+        for (size_t i = 0; i < q.body.size(); ++i) {
+            const Atom& atom = q.body[i];
+            string sig = symbols.name(atom.relation) + "(";
+            for (const auto& t : atom.terms) {
+                sig += t.is_variable ? to_string(color[t.id]) 
+                                     : "'" + symbols.name(t.id) + "'";
+                sig += ",";
             }
+            atom_sig[i] = sig + ")";
         }
-        return true;
+        map<int, vector<string>> occurrences;
+        for (size_t i = 0; i < q.body.size(); ++i) {
+            const auto& terms = q.body[i].terms;
+            for (size_t pos = 0; pos < terms.size(); ++pos) {
+                if (!terms[pos].is_variable) continue;
+                occurrences[terms[pos].id].push_back(atom_sig[i] + "@" + to_string(pos));
+            }
+        }
+        map<string, vector<int>> classes;
+        for (auto& [v, c] : color) {
+            auto& occ = occurrences[v];
+            sort(occ.begin(), occ.end());
+            string sig = to_string(c) + "|";
+            for (const auto& o : occ) sig += o + ";";
+            classes[sig].push_back(v);
+        }
+        int next_color = 0;
+        for (const auto& [sig, vars] : classes) {
+            for (int v : vars) color[v] = next_color;
+            ++next_color;
+        }
+        if (classes.size() == n_classes) break;
+        n_classes = classes.size();
     }
     
-    // Merge two mappings
-    Mapping mergeMappings(const Mapping& m1, const Mapping& m2) {
-        Mapping merged = m1;
-        for (const auto& [key, val] : m2) {
-            merged[key] = val;
+    CanonicalQuery canon;
+    canon.atom_order.resize(q.body.size());
+    for (size_t i = 0; i < q.body.size(); ++i) canon.atom_order[i] = i;
+    stable_sort(canon.atom_order.begin(), canon.atom_order.end(),
+                [&](int a, int b) { return atom_sig[a] < atom_sig[b]; });
+    
+    map<int, int> number;
+    auto numberOf = [&](int var) {
+        auto it = number.find(var);
+        if (it != number.end()) return it->second;
+        int n = canon.variables.size();
+        canon.variables.push_back(var);
+        number[var] = n;
+        return n;
+    };
+    
+    string& fp = canon.fingerprint;
+    for (int i : canon.atom_order) {
+        const Atom& atom = q.body[i];
+        fp += symbols.name(atom.relation) + "(";
+        for (size_t pos = 0; pos < atom.terms.size(); ++pos) {
+            const Term& t = atom.terms[pos];
+            if (pos > 0) fp += ",";
+            fp += t.is_variable ? "v" + to_string(numberOf(t.id)) 
+                                : "'" + symbols.name(t.id) + "'";
         }
-        return merged;
+        fp += ");";
     }
-    
-    // Check if view atom can map to query atom
-    bool canMap(const Atom& view_atom, const Atom& query_atom, 
-                Mapping& mapping) {
-        if (view_atom.relation != query_atom.relation) return false;
-        if (view_atom.terms.size() != query_atom.terms.size()) return false;
-        
-        Mapping temp_mapping;
-        
-        for (size_t i = 0; i < view_atom.terms.size(); ++i) {
-            const Term& v_term = view_atom.terms[i];
-            const Term& q_term = query_atom.terms[i];
-            
-            if (v_term.is_variable) {
-                // View variable must map consistently
-                if (temp_mapping.find(v_term.value) != temp_mapping.end()) {
-                    if (temp_mapping[v_term.value] != q_term.value) {
-                        return false;
-                    }
-                } else {
-                    temp_mapping[v_term.value] = q_term.value;
-                }
-            } else {
-                // View constant must match query term exactly
-                if (q_term.is_variable || v_term.value != q_term.value) {
-                    return false;
-                }
-            }
+    set<int> head_numbers;
+    for (int v : head_vars) head_numbers.insert(numberOf(v));
+    fp += "head{";
+    for (int n : head_numbers) fp += "v" + to_string(n) + ",";
+    fp += "}";
+    map<int, string> range_by_number;
+    for (const auto& [v, range] : ranges) {
+        range_by_number[numberOf(v)] = range.toString();
+    }
+    for (const auto& [n, range] : range_by_number) {
+        fp += "v" + to_string(n) + range;
+    }
+    // Aggregates in query order, since rewritings refer to them by position
+    if (q.isAggregate()) {
+        set<int> group_numbers;
+        for (int v : q.group_by) group_numbers.insert(numberOf(v));
+        fp += "group{";
+        for (int n : group_numbers) fp += "v" + to_string(n) + ",";
+        fp += "}";
+        for (const auto& agg : q.aggregates) {
+            fp += string(Aggregate::opString(agg.op)) + "(" + 
+                  (agg.arg == -1 ? string("*") : "v" + to_string(numberOf(agg.arg))) + ")";
         }
-        
-        // Check consistency with existing mapping
-        if (!isConsistentMapping(mapping, temp_mapping)) {
+    }
+    return canon;
+}
+
+// Rewritings stored in canonical terms: mapping images are canonical
+// variable numbers and covered subgoals canonical atom positions, so an
+// entry can be replayed for any query with the same fingerprint
+struct CachedRewriting {
+    vector<int> view_indices;
+    vector<Mapping> mappings;
+    vector<DynamicBitset> view_atoms;
+    vector<int> covered_subgoals;
+    double cost = 0;
+    vector<AggregateTerm> aggregate_terms;
+    bool regroup = false;
+};
+
+// LRU cache of rewriting results keyed by catalog version + fingerprint
+class RewritingCache {
+public:
+    explicit RewritingCache(size_t cap) : capacity(cap) {}
+    
+    bool lookup(const string& key, vector<CachedRewriting>& result) {
+        lock_guard<mutex> lock(mu);
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            ++misses;
             return false;
         }
-        
-        mapping = mergeMappings(mapping, temp_mapping);
+        lru.splice(lru.begin(), lru, it->second);
+        result = it->second->second;
+        ++hits;
         return true;
     }
     
-    // Find all possible MCDs for a view
-    void findMCDsForView(int view_idx) {
-        const ConjunctiveQuery& view = views[view_idx];
-        int n_subgoals = query.body.size();
-        
-        // Try to cover each query subgoal
-        for (int sg_idx = 0; sg_idx < n_subgoals; ++sg_idx) {
-            const Atom& query_atom = query.body[sg_idx];
-            
-            // Try to match with each view subgoal
-            for (size_t v_sg_idx = 0; v_sg_idx < view.body.size(); ++v_sg_idx) {
-                const Atom& view_atom = view.body[v_sg_idx];
-                
-                Mapping mapping;
-                if (canMap(view_atom, query_atom, mapping)) {
-                    // Found a potential MCD, now extend it
-                    MCD mcd;
-                    mcd.view_index = view_idx;
-                    mcd.covered_subgoals.insert(sg_idx);
-                    mcd.variable_mapping = mapping;
-                    
-                    // Try to extend by covering more subgoals
-                    extendMCD(view_idx, mcd);
-                }
-            }
+    void insert(const string& key, vector<CachedRewriting> result) {
+        lock_guard<mutex> lock(mu);
+        if (capacity == 0) return;
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second->second = move(result);
+            lru.splice(lru.begin(), lru, it->second);
+            return;
+        }
+        lru.emplace_front(key, move(result));
+        entries[key] = lru.begin();
+        if (entries.size() > capacity) {
+            entries.erase(lru.back().first);
+            lru.pop_back();
         }
     }
     
-    // Extend MCD by covering additional subgoals
-    void extendMCD(int view_idx, MCD& mcd) {
-        const ConjunctiveQuery& view = views[view_idx];
-        bool extended = true;
-        
-        while (extended) {
-            extended = false;
-            
-            // Try to cover additional query subgoals
-            for (size_t sg_idx = 0; sg_idx < query.body.size(); ++sg_idx) {
-                if (mcd.covered_subgoals.find(sg_idx) != mcd.covered_subgoals.end()) {
-                    continue; // Already covered
-                }
-                
-                const Atom& query_atom = query.body[sg_idx];
-                
-                // Try each view subgoal
-                for (const auto& view_atom : view.body) {
-                    Mapping temp_mapping = mcd.variable_mapping;
-                    if (canMap(view_atom, query_atom, temp_mapping)) {
-                        mcd.covered_subgoals.insert(sg_idx);
-                        mcd.variable_mapping = temp_mapping;
-                        extended = true;
-                        break;
-                    }
-                }
-            }
+    size_t size() const {
+        lock_guard<mutex> lock(mu);
+        return entries.size();
+    }
+    
+    size_t hits = 0;
+    size_t misses = 0;
+    
+private:
+    using Entry = pair<string, vector<CachedRewriting>>;
+    size_t capacity;
+    mutable mutex mu;
+    list<Entry> lru;
+    unordered_map<string, list<Entry>::iterator> entries;
+};
+
+// ============================================================================
+// QUERY CONTAINMENT
+// ============================================================================
+
+// Backtracking search for a homomorphism from the body of `from` into the
+// body of `to` that sends the i-th head term of `from` to the i-th head
+// term of `to`. Such a homomorphism exists exactly when `to` is contained
+// in `from` (with range predicates it is sufficient, not necessary: each
+// variable's range is checked on its own). Terms are compared by symbol
+// ID; variable IDs that are not in
+// the symbol table (fresh variables from view expansion) are fine, since
+// nothing is ever looked up by name.
+class HomomorphismSearch {
+public:
+    HomomorphismSearch(const ConjunctiveQuery& f, const ConjunctiveQuery& t)
+        : from(f), to(t), from_ranges(f.intervals()), to_ranges(t.intervals()) {}
+    
+    bool run() {
+        if (from.head.size() != to.head.size()) return false;
+        for (size_t i = 0; i < from.head.size(); ++i) {
+            if (!bind(from.head[i], to.head[i])) return false;
         }
         
-        // Check which distinguished variables are covered
-        for (const auto& head_term : query.head) {
-            if (head_term.is_variable) {
-                // Check if this variable is in the mapping range
-                for (const auto& [v_var, q_var] : mcd.variable_mapping) {
-                    if (q_var == head_term.value) {
-                        // Check if v_var is in view's head
-                        for (const auto& v_head_term : view.head) {
-                            if (v_head_term.value == v_var) {
-                                mcd.distinguished_vars.insert(head_term.value);
-                                break;
-                            }
-                        }
-                    }
+        // Atoms with the fewest candidate targets are matched first
+        candidates.assign(from.body.size(), {});
+        for (size_t i = 0; i < from.body.size(); ++i) {
+            for (size_t j = 0; j < to.body.size(); ++j) {
+                if (from.body[i].relation == to.body[j].relation &&
+                    from.body[i].terms.size() == to.body[j].terms.size()) {
+                    candidates[i].push_back(j);
                 }
             }
+            if (candidates[i].empty()) return false;
+            order.push_back(i);
         }
-        
-        // Only add MCD if it covers at least one subgoal
-        if (!mcd.covered_subgoals.empty()) {
-            mcds.push_back(mcd);
+        sort(order.begin(), order.end(), [&](int a, int b) {
+            return candidates[a].size() < candidates[b].size();
+        });
+        return matchFrom(0);
+    }
+    
+private:
+    // Map source term `s` onto target term `t`, recording new bindings. A
+    // range-restricted source variable needs a target variable whose range
+    // lies inside its own, so the target's predicates imply the source's.
+    bool bind(const Term& s, const Term& t) {
+        if (!s.is_variable) return s == t;
+        auto it = assignment.find(s.id);
+        if (it != assignment.end()) return it->second == t;
+        auto range = from_ranges.find(s.id);
+        if (range != from_ranges.end()) {
+            if (!t.is_variable) return false;
+            auto target = to_ranges.find(t.id);
+            Interval target_range = target != to_ranges.end() ? target->second : Interval();
+            if (!range->second.contains(target_range)) return false;
         }
+        assignment.emplace(s.id, t);
+        trail.push_back(s.id);
+        return true;
     }
     
-    /// Check if a combination of MCDs covers all subgoals and head variables
-    bool isValidRewriting(const vector<MCD>& mcd_combo) {
-        set<int> all_covered;
-        set<string> all_distinguished;
-
-        for (const auto& mcd : mcd_combo) {
-            all_covered.insert(mcd.covered_subgoals.begin(),
-                             mcd.covered_subgoals.end());
-            all_distinguished.insert(mcd.distinguished_vars.begin(),
-                                   mcd.distinguished_vars.end());
+    bool matchFrom(size_t k) {
+        if (k == order.size()) return true;
+        const Atom& atom = from.body[order[k]];
+        for (int j : candidates[order[k]]) {
+            const Atom& target = to.body[j];
+            size_t mark = trail.size();
+            bool ok = true;
+            for (size_t p = 0; ok && p < atom.terms.size(); ++p) {
+                ok = bind(atom.terms[p], target.terms[p]);
+            }
+            if (ok && matchFrom(k + 1)) return true;
+            while (trail.size() > mark) {
+                assignment.erase(trail.back());
+                trail.pop_back();
+            }
         }
+        return false;
+    }
+    
+    const ConjunctiveQuery& from;
+    const ConjunctiveQuery& to;
+    map<int, Interval> from_ranges;
+    map<int, Interval> to_ranges;
+    vector<vector<int>> candidates;
+    vector<int> order;
+    unordered_map<int, Term> assignment;
+    vector<int> trail;
+};
 
-        // Check if all subgoals are covered
-        if (all_covered.size() != query.body.size()) {
-            return false;
-        }
+// Is every answer of q1 also an answer of q2 (q1 is contained in q2)?
+bool isContainedIn(const ConjunctiveQuery& q1, const ConjunctiveQuery& q2) {
+    return HomomorphismSearch(q2, q1).run();
+}
 
-        // Check if all head variables are covered (require subset)
-        auto query_head_vars = query.getHeadVariables();
-        for (const auto &hv : query_head_vars) {
-            if (all_distinguished.find(hv) == all_distinguished.end()) {
-                return false;
-            }
-        }
+// Core of a conjunctive query: drop body atoms one at a time as long as
+// the original query still maps homomorphically into what is left. The
+// result is equivalent to `q` and has no redundant subgoals.
+ConjunctiveQuery minimizeQuery(const ConjunctiveQuery& q) {
+    ConjunctiveQuery core = q;
+    for (size_t i = core.body.size(); i-- > 0;) {
+        ConjunctiveQuery candidate = core;
+        candidate.body.erase(candidate.body.begin() + i);
+        // Range predicates on variables that left with the atom go too
+        set<int> vars = candidate.getVariables();
+        candidate.comparisons.erase(
+            remove_if(candidate.comparisons.begin(), candidate.comparisons.end(),
+                      [&](const Comparison& c) { return !vars.count(c.var); }),
+            candidate.comparisons.end());
+        if (isContainedIn(candidate, core)) core = move(candidate);
+    }
+    return core;
+}
 
-        // Check compatibility of mappings
-        for (size_t i = 0; i < mcd_combo.size(); ++i) {
-            for (size_t j = i + 1; j < mcd_combo.size(); ++j) {
-                if (!isConsistentMapping(mcd_combo[i].variable_mapping,
-                                        mcd_combo[j].variable_mapping)) {
-                    return false;
-                                        }
+// ============================================================================
+// EXACT COVER (DANCING LINKS)
+// ============================================================================
+
+// Knuth's Algorithm X on a dancing-links matrix, extended with a pairwise
+// compatibility relation between rows: choosing a row also hides every
+// remaining row it is incompatible with, so column sizes always count
+// only rows that can still join the partial cover and a column that runs
+// empty fails immediately. Each column must be covered exactly once.
+class DancingLinks {
+public:
+    // `rows[r]` lists the columns row r covers; `compatible[r]` has bit q
+    // set when rows r and q may appear in the same cover
+    DancingLinks(size_t n_columns, const vector<vector<int>>& rows,
+                 const vector<DynamicBitset>& compatible)
+        : compat(compatible), active(rows.size()) {
+        // Node 0 is the root; nodes 1..n_columns are column headers
+        for (size_t c = 0; c <= n_columns; ++c) {
+            addNode(c, -1);
+            L[c] = c == 0 ? n_columns : c - 1;
+            R[c] = c == n_columns ? 0 : c + 1;
+        }
+        size.assign(n_columns + 1, 0);
+        for (size_t r = 0; r < rows.size(); ++r) {
+            int first = -1;
+            for (int col : rows[r]) {
+                int c = col + 1;
+                int node = addNode(c, r);
+                U[node] = U[c];
+                D[node] = c;
+                D[U[c]] = node;
+                U[c] = node;
+                ++size[c];
+                if (first == -1) {
+                    first = node;
+                    L[node] = R[node] = node;
+                } else {
+                    L[node] = L[first];
+                    R[node] = first;
+                    R[L[first]] = node;
+                    L[first] = node;
+                }
             }
+            row_head.push_back(first);
         }
-        return true;
+        active.setAll();
     }
-
     
-    // Generate all combinations of MCDs
-    void generateRewritings(vector<QueryRewriting>& rewritings) {
-        int n_subgoals = query.body.size();
+    // Call `found` with the rows of every exact cover
+    void search(const function<void(const vector<int>&)>& found) {
+        if (R[0] == 0) {
+            found(solution);
+            return;
+        }
+        // Column with the fewest live rows; ties go to the lowest column
+        int c = R[0];
+        for (int j = R[c]; j != 0; j = R[j]) {
+            if (size[j] < size[c]) c = j;
+        }
+        if (size[c] == 0) return;
         
-        // Generate all subsets of MCDs
-        int n_mcds = mcds.size();
-        for (int mask = 1; mask < (1 << n_mcds); ++mask) {
-            vector<MCD> combo;
+        cover(c);
+        for (int r = D[c]; r != c; r = D[r]) {
+            int row = row_of[r];
+            solution.push_back(row);
+            for (int j = R[r]; j != r; j = R[j]) cover(col_of[j]);
             
-            for (int i = 0; i < n_mcds; ++i) {
-                if (mask & (1 << i)) {
-                    combo.push_back(mcds[i]);
-                }
+            vector<int> hidden;
+            DynamicBitset conflicting = active;
+            conflicting.subtract(compat[row]);
+            for (int q : conflicting) {
+                hideRow(q);
+                hidden.push_back(q);
             }
             
-            if (isValidRewriting(combo)) {
-                QueryRewriting rewriting;
-                for (const auto& mcd : combo) {
-                    rewriting.view_indices.push_back(mcd.view_index);
-                    rewriting.mappings.push_back(mcd.variable_mapping);
-                }
-                rewriting.covered_subgoals.insert(
-                    combo[0].covered_subgoals.begin(),
-                    combo[0].covered_subgoals.end()
-                );
-                for (size_t i = 1; i < combo.size(); ++i) {
-                    rewriting.covered_subgoals.insert(
-                        combo[i].covered_subgoals.begin(),
-                        combo[i].covered_subgoals.end()
-                    );
-                }
-                rewritings.push_back(rewriting);
-            }
+            search(found);
+            
+            for (auto it = hidden.rbegin(); it != hidden.rend(); ++it) unhideRow(*it);
+            for (int j = L[r]; j != r; j = L[j]) uncover(col_of[j]);
+            solution.pop_back();
         }
+        uncover(c);
     }
     
-public:
-    ConjunctiveQuery query_cq; // Store original query for SQL output
+private:
+    int addNode(int column, int row) {
+        L.push_back(0); R.push_back(0);
+        U.push_back(L.size() - 1); D.push_back(L.size() - 1);
+        col_of.push_back(column);
+        row_of.push_back(row);
+        return L.size() - 1;
+    }
     
-    void setQuery(const ConjunctiveQuery& q) {
-        query = q;
-        query_cq = q;
+    // Detach a column and every row that uses it from the other columns
+    void cover(int c) {
+        R[L[c]] = R[c];
+        L[R[c]] = L[c];
+        for (int i = D[c]; i != c; i = D[i]) {
+            active.reset(row_of[i]);
+            for (int j = R[i]; j != i; j = R[j]) {
+                D[U[j]] = D[j];
+                U[D[j]] = U[j];
+                --size[col_of[j]];
+            }
+        }
     }
     
-    void addView(const ConjunctiveQuery& v) {
-        views.push_back(v);
+    void uncover(int c) {
+        for (int i = U[c]; i != c; i = U[i]) {
+            for (int j = L[i]; j != i; j = L[j]) {
+                ++size[col_of[j]];
+                D[U[j]] = j;
+                U[D[j]] = j;
+            }
+            active.set(row_of[i]);
+        }
+        R[L[c]] = c;
+        L[R[c]] = c;
     }
     
-    vector<QueryRewriting> rewrite() {
-        mcds.clear();
-        
-        cout << "\n=== Step 1: Finding MCDs for each view ===\n";
-        // Find all MCDs
-        for (size_t i = 0; i < views.size(); ++i) {
-            cout << "\nProcessing View " << i << ": " 
-                     << views[i].toString() << "\n";
-            findMCDsForView(i);
+    // Detach a single live row from all of its columns
+    void hideRow(int row) {
+        int first = row_head[row];
+        int j = first;
+        do {
+            D[U[j]] = D[j];
+            U[D[j]] = U[j];
+            --size[col_of[j]];
+            j = R[j];
+        } while (j != first);
+        active.reset(row);
+    }
+    
+    void unhideRow(int row) {
+        int first = row_head[row];
+        int j = L[first];
+        while (true) {
+            ++size[col_of[j]];
+            D[U[j]] = j;
+            U[D[j]] = j;
+            if (j == first) break;
+            j = L[j];
         }
-        
-        cout << "\nFound " << mcds.size() << " MCDs:\n";
-        for (size_t i = 0; i < mcds.size(); ++i) {
-            cout << "  MCD " << i << ": View V" << mcds[i].view_index 
-                     << " covers subgoals {";
-            bool first = true;
-            for (int sg : mcds[i].covered_subgoals) {
+        active.set(row);
+    }
+    
+    vector<int> L, R, U, D, col_of, row_of;
+    vector<int> size;
+    vector<int> row_head;
+    const vector<DynamicBitset>& compat;
+    DynamicBitset active;       // Rows still linked into their columns
+    vector<int> solution;
+};
+
+// ============================================================================
+// MINICON ALGORITHM
+// ============================================================================
+
+// Position of one atom inside the view catalog
+struct ViewAtomRef {
+    int view_index;
+    int atom_index;
+    
+    bool operator<(const ViewAtomRef& other) const {
+        if (view_index != other.view_index) return view_index < other.view_index;
+        return atom_index < other.atom_index;
+    }
+};
+
+// Seed matches (canMap from an empty mapping) of the view atoms against
+// the subgoals of a group of queries, computed once per catalog version
+// before the group is rewritten. Queries converted with the same symbol
+// table share subgoals such as Customer(Customer_name,
+// Customer_nationkey), and each distinct subgoal is then matched once.
+// The table is never written after it is built, so MCD formation reads
+// it without locking.
+struct SeedTable {
+    // A subgoal's relation followed by its terms (constants negated)
+    using Signature = vector<int>;
+    // Matching view atoms in ascending order, each with its seed mapping
+    using Seeds = vector<pair<ViewAtomRef, Mapping>>;
+    
+    uint64_t version = UINT64_MAX;
+    map<Signature, Seeds> entries;
+    
+    static Signature signature(const Atom& atom) {
+        Signature sig{atom.relation};
+        for (const auto& t : atom.terms) {
+            sig.push_back(t.is_variable ? t.id : -1 - t.id);
+        }
+        return sig;
+    }
+    
+    // Seeds of a subgoal, or null if it was not in the group
+    const Seeds* find(const Atom& atom) const {
+        auto it = entries.find(signature(atom));
+        return it == entries.end() ? nullptr : &it->second;
+    }
+};
+
+// Statistics StatisticsBuilder collects for one column: counts, average
+// width, the range of a numeric column and an equi-depth histogram of it
+struct ColumnStatistics {
+    double rows = 0;            // Including NULLs
+    double nulls = 0;
+    double distinct = 0;        // Estimated distinct non-NULL values
+    double width = 0;           // Average bytes per non-NULL value
+    bool has_range = false;     // Numeric column with some non-NULL value
+    double min = 0;
+    double max = 0;
+    // Equi-depth histogram of a numeric column: bucket i spans
+    // [bounds[i], bounds[i + 1]] and holds an equal share of the non-NULL
+    // rows
+    vector<double> bounds;
+    
+    // Estimated fraction of all rows whose value lies in `range`, taking
+    // values as spread evenly within each bucket
+    double fractionIn(const Interval& range) const {
+        if (rows == 0 || bounds.size() < 2) return 0;
+        size_t n_buckets = bounds.size() - 1;
+        double covered = 0;
+        for (size_t b = 0; b < n_buckets; ++b) {
+            double lo = bounds[b], hi = bounds[b + 1];
+            if (lo == hi) {
+                Interval point;
+                point.lo = point.hi = lo;
+                covered += range.contains(point) ? 1 : 0;
+                continue;
+            }
+            double from = std::max(lo, range.lo), to = std::min(hi, range.hi);
+            if (to > from) covered += (to - from) / (hi - lo);
+        }
+        return covered / n_buckets * (rows - nulls) / rows;
+    }
+};
+
+// Catalog statistics for one view, keyed by the view's head variable IDs.
+// Columns without an entry fall back to the row count (distinct values)
+// and DEFAULT_COLUMN_WIDTH (bytes).
+struct ViewStatistics {
+    static constexpr double DEFAULT_ROW_COUNT = 1000;
+    static constexpr double DEFAULT_COLUMN_WIDTH = 8;
+    
+    double row_count = DEFAULT_ROW_COUNT;
+    map<int, double> distinct_counts;
+    map<int, double> column_widths;
+    map<int, ColumnStatistics> columns;     // Collected detail, if any
+    
+    double distinct(int var) const {
+        auto it = distinct_counts.find(var);
+        return it == distinct_counts.end() ? row_count : min(it->second, row_count);
+    }
+    
+    double width(int var) const {
+        auto it = column_widths.find(var);
+        return it == column_widths.end() ? DEFAULT_COLUMN_WIDTH : it->second;
+    }
+};
+
+// Running estimate for a left-deep join of view occurrences. Cost adds
+// each view's scan (rows x width) and each intermediate result, so it
+// never decreases as views are added and a partial estimate is a lower
+// bound for any completion of it.
+struct JoinEstimate {
+    double rows = 0;
+    double width = 0;
+    double cost = 0;
+    map<int, double> distinct;  // Query variable ID -> distinct values
+    bool empty = true;
+};
+
+// Static index over intervals for overlap queries: entries sorted by
+// lower end, plus a segment tree holding the largest upper end of each
+// range of that order. The entries that can overlap [lo, hi] form the
+// prefix whose lower end is at most hi; the tree walk descends only into
+// nodes whose largest upper end reaches lo, so a query costs
+// O(log n + k) for k results.
+class IntervalIndex {
+public:
+    void build(vector<pair<Interval, ViewAtomRef>> items) {
+        sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+            return a.first.lo < b.first.lo;
+        });
+        entries = move(items);
+        size_t n = entries.size();
+        max_hi.assign(2 * n, -numeric_limits<double>::infinity());
+        for (size_t i = 0; i < n; ++i) max_hi[n + i] = entries[i].first.hi;
+        for (size_t i = n; i-- > 1;) max_hi[i] = max(max_hi[2 * i], max_hi[2 * i + 1]);
+    }
+    
+    // Entries whose interval overlaps `range`, appended in no set order
+    void overlapping(const Interval& range, vector<ViewAtomRef>& out) const {
+        size_t n = entries.size();
+        size_t prefix = upper_bound(entries.begin(), entries.end(), range.hi,
+                                    [](double hi, const auto& e) { return hi < e.first.lo; })
+                        - entries.begin();
+        if (prefix == 0) return;
+        
+        // Walk the bottom-up segment tree over [0, prefix)
+        vector<size_t> stack;
+        for (size_t l = n, r = n + prefix; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) stack.push_back(l++);
+            if (r & 1) stack.push_back(--r);
+        }
+        while (!stack.empty()) {
+            size_t node = stack.back();
+            stack.pop_back();
+            if (max_hi[node] < range.lo) continue;
+            if (node >= n) {
+                Interval overlap = entries[node - n].first;
+                overlap.intersect(range);
+                if (!overlap.empty()) out.push_back(entries[node - n].second);
+                continue;
+            }
+            stack.push_back(2 * node);
+            stack.push_back(2 * node + 1);
+        }
+    }
+    
+private:
+    vector<pair<Interval, ViewAtomRef>> entries;
+    vector<double> max_hi;
+};
+
+// Range predicates of the view atoms over one (relation, column position):
+// atoms with a bounded interval there go into the index, the rest are
+// listed as unbounded and overlap anything
+struct ColumnRangeIndex {
+    IntervalIndex bounded;
+    vector<ViewAtomRef> unbounded;
+};
+
+// Long-lived set of views that many queries are rewritten against. Views
+// are converted and indexed once when added; removing a view leaves a
+// tombstone so view IDs, and rewritings that refer to them, stay valid.
+// Every change bumps `version`, which keys cached rewritings. Rewrites
+// hold a shared lock, changes an exclusive one.
+class ViewCatalog {
+public:
+    explicit ViewCatalog(shared_ptr<SymbolTable> table = make_shared<SymbolTable>())
+        : symbols(move(table)) {}
+    
+    // Views by ID; removed views keep their slot (see `live`)
+    vector<ConjunctiveQuery> views;
+    vector<ViewStatistics> stats;
+    vector<string> storage;                 // Columnar file of each view's rows,
+                                            // empty if not persisted
+    vector<map<int, Interval>> intervals;   // Range of each compared view variable
+    vector<map<int, Interval>> matched_intervals;   // Same plus outer-join ON
+                                                    // predicates
+    vector<bool> live;
+    
+    // Symbol table shared by all views and the queries rewritten against
+    // them; fixed for the catalog's lifetime
+    const shared_ptr<SymbolTable> symbols;
+    
+    uint64_t version = 0;
+    
+    // Inverted index: relation symbol ID -> every live view atom over that
+    // relation, in (view, atom) order. MCD formation only visits these
+    // candidates instead of testing every view atom against every subgoal.
+    vector<vector<ViewAtomRef>> atoms_by_relation;
+    
+    bool usesSymbols(const ConjunctiveQuery& cq) const {
+        if (cq.symbols != symbols) {
+            cerr << "ViewCatalog: " << cq.name 
+                 << " was converted with a different symbol table\n";
+            return false;
+        }
+        return true;
+    }
+    
+    // Returns the new view's ID, or -1 if it uses another symbol table
+    int addView(const ConjunctiveQuery& v, 
+                const ViewStatistics& view_stats = ViewStatistics()) {
+        unique_lock<shared_mutex> lock(mutex);
+        if (!usesSymbols(v)) return -1;
+        int view_idx = views.size();
+        views.push_back(v);
+        stats.push_back(view_stats);
+        storage.push_back("");
+        intervals.push_back(v.intervals());
+        matched_intervals.push_back(v.intervals(true));
+        live.push_back(true);
+        for (size_t i = 0; i < v.body.size(); ++i) {
+            int rel = v.body[i].relation;
+            if (rel >= (int)atoms_by_relation.size()) {
+                atoms_by_relation.resize(rel + 1);
+            }
+            atoms_by_relation[rel].push_back({view_idx, (int)i});
+        }
+        ++version;
+        return view_idx;
+    }
+    
+    // Convert and add a view given as SQL, interning into the catalog's table
+    int addView(const string& sql, const string& name,
+                const ViewStatistics& view_stats = ViewStatistics()) {
+        return addView(converter().convert(sql, name), view_stats);
+    }
+    
+    bool removeView(int view_idx) {
+        unique_lock<shared_mutex> lock(mutex);
+        if (!isLive(view_idx)) return false;
+        live[view_idx] = false;
+        for (const auto& atom : views[view_idx].body) {
+            auto& refs = atoms_by_relation[atom.relation];
+            refs.erase(remove_if(refs.begin(), refs.end(),
+                                 [&](const ViewAtomRef& r) { return r.view_index == view_idx; }),
+                       refs.end());
+        }
+        ++version;
+        return true;
+    }
+    
+    void setViewStatistics(int view_idx, const ViewStatistics& view_stats) {
+        unique_lock<shared_mutex> lock(mutex);
+        stats[view_idx] = view_stats;
+        ++version;
+    }
+    
+    // Where the view's materialized rows are kept (see ColumnarFile). Not
+    // a change to the views, so the version stays.
+    void setViewStorage(int view_idx, const string& path) {
+        unique_lock<shared_mutex> lock(mutex);
+        storage[view_idx] = path;
+    }
+    
+    // Interval indexes keyed by (relation, column position), for the
+    // positions some live view constrains. Rebuilt on first use after a
+    // change; readers holding the shared lock may race to rebuild, so the
+    // rebuild has a lock of its own.
+    const map<pair<int, int>, ColumnRangeIndex>& rangeIndex() const {
+        lock_guard<std::mutex> lock(range_mutex);
+        if (range_index_version == version) return range_index;
+        range_index.clear();
+        for (size_t v = 0; v < views.size(); ++v) {
+            if (!live[v]) continue;
+            for (size_t a = 0; a < views[v].body.size(); ++a) {
+                const Atom& atom = views[v].body[a];
+                for (size_t pos = 0; pos < atom.terms.size(); ++pos) {
+                    if (intervals[v].count(atom.terms[pos].id)) {
+                        range_index[{atom.relation, (int)pos}];
+                    }
+                }
+            }
+        }
+        for (auto& [key, column] : range_index) {
+            const auto& [relation, pos] = key;
+            vector<pair<Interval, ViewAtomRef>> items;
+            for (const auto& ref : atoms_by_relation[relation]) {
+                const Term& t = views[ref.view_index].body[ref.atom_index].terms[pos];
+                auto range = intervals[ref.view_index].find(t.id);
+                if (range != intervals[ref.view_index].end()) {
+                    items.push_back({range->second, ref});
+                } else {
+                    column.unbounded.push_back(ref);
+                }
+            }
+            column.bounded.build(move(items));
+        }
+        range_index_version = version;
+        return range_index;
+    }
+    
+    bool isLive(int view_idx) const {
+        return view_idx >= 0 && view_idx < (int)views.size() && live[view_idx];
+    }
+    
+    // Converter that interns into this catalog's symbol table, for queries.
+    // It knows the TPC-H schema, so every atom over a TPC-H table lists
+    // the same columns at the same positions whichever of them the SQL
+    // mentions; views added as SQL are converted the same way.
+    SQLToConjunctiveQuery converter() const {
+        SQLToConjunctiveQuery c(symbols);
+        c.addTPCHSchema();
+        return c;
+    }
+    
+    shared_lock<shared_mutex> readLock() const {
+        return shared_lock<shared_mutex>(mutex);
+    }
+    
+private:
+    mutable shared_mutex mutex;
+    mutable std::mutex range_mutex;
+    mutable map<pair<int, int>, ColumnRangeIndex> range_index;
+    mutable uint64_t range_index_version = UINT64_MAX;
+};
+
+class MiniCon {
+public:
+    ConjunctiveQuery query;
+    vector<MCD> mcds;
+    
+    // Views, their statistics and the relation index; may be shared with
+    // other MiniCon instances rewriting other queries
+    shared_ptr<ViewCatalog> catalog;
+    
+    explicit MiniCon(shared_ptr<ViewCatalog> shared_catalog = make_shared<ViewCatalog>())
+        : catalog(shared_catalog) {}
+    
+    // Atoms of view `view_idx` over `relation`, as a range of the index
+    pair<vector<ViewAtomRef>::const_iterator, vector<ViewAtomRef>::const_iterator>
+    viewAtomsFor(int relation, int view_idx) const {
+        static const vector<ViewAtomRef> none;
+        if (relation < 0 || relation >= (int)catalog->atoms_by_relation.size()) {
+            return {none.end(), none.end()};
+        }
+        const auto& refs = catalog->atoms_by_relation[relation];
+        return equal_range(refs.begin(), refs.end(), ViewAtomRef{view_idx, 0},
+                           [](const ViewAtomRef& a, const ViewAtomRef& b) {
+                               return a.view_index < b.view_index;
+                           });
+    }
+    
+    // Per query subgoal, the view atoms whose range predicates overlap the
+    // query's on every indexed column; only meaningful where
+    // `range_filtered` is set, other subgoals seed from every atom over
+    // their relation
+    vector<vector<ViewAtomRef>> range_seeds;
+    vector<bool> range_filtered;
+    
+    // Narrow the seed atoms of range-restricted subgoals with the
+    // catalog's interval indexes. An atom left out here would fail
+    // rangesCompatible anyway, so this only saves work. Returns whether
+    // any subgoal was narrowed.
+    bool filterSeedsByRange() {
+        range_seeds.assign(query.body.size(), {});
+        range_filtered.assign(query.body.size(), false);
+        if (query_intervals.empty()) return false;
+        
+        const auto& index = catalog->rangeIndex();
+        bool any = false;
+        for (size_t sg = 0; sg < query.body.size(); ++sg) {
+            const Atom& atom = query.body[sg];
+            for (size_t pos = 0; pos < atom.terms.size(); ++pos) {
+                auto range = query_intervals.find(atom.terms[pos].id);
+                if (range == query_intervals.end()) continue;
+                auto column = index.find({atom.relation, (int)pos});
+                if (column == index.end()) continue;
+                
+                vector<ViewAtomRef> matching = column->second.unbounded;
+                column->second.bounded.overlapping(range->second, matching);
+                sort(matching.begin(), matching.end());
+                if (range_filtered[sg]) {
+                    vector<ViewAtomRef> both;
+                    set_intersection(range_seeds[sg].begin(), range_seeds[sg].end(),
+                                     matching.begin(), matching.end(), back_inserter(both));
+                    matching = move(both);
+                }
+                range_seeds[sg] = move(matching);
+                range_filtered[sg] = true;
+                any = true;
+            }
+        }
+        return any;
+    }
+    
+    // Atoms of view `view_idx` that may seed an MCD for subgoal `sg`
+    pair<vector<ViewAtomRef>::const_iterator, vector<ViewAtomRef>::const_iterator>
+    seedAtomsFor(int sg, int view_idx) const {
+        if (sg >= (int)range_filtered.size() || !range_filtered[sg]) {
+            return viewAtomsFor(query.body[sg].relation, view_idx);
+        }
+        return equal_range(range_seeds[sg].begin(), range_seeds[sg].end(), 
+                           ViewAtomRef{view_idx, 0},
+                           [](const ViewAtomRef& a, const ViewAtomRef& b) {
+                               return a.view_index < b.view_index;
+                           });
+    }
+    
+    // Views with at least one seed atom for a subgoal of the query, ascending
+    vector<int> candidateViews() const {
+        vector<int> candidates;
+        for (size_t sg = 0; sg < query.body.size(); ++sg) {
+            const Atom& atom = query.body[sg];
+            if (sg < range_filtered.size() && range_filtered[sg]) {
+                for (const auto& ref : range_seeds[sg]) candidates.push_back(ref.view_index);
+                continue;
+            }
+            if (atom.relation >= (int)catalog->atoms_by_relation.size()) continue;
+            for (const auto& ref : catalog->atoms_by_relation[atom.relation]) {
+                candidates.push_back(ref.view_index);
+            }
+        }
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        return candidates;
+    }
+    
+    // Check if a mapping is consistent (no conflicts). Both mappings are
+    // sorted by key, so a single merge pass suffices.
+    bool isConsistentMapping(const Mapping& m1, const Mapping& m2) const {
+        auto it1 = m1.begin(), it2 = m2.begin();
+        while (it1 != m1.end() && it2 != m2.end()) {
+            if (it1->first < it2->first) {
+                ++it1;
+            } else if (it2->first < it1->first) {
+                ++it2;
+            } else {
+                if (it1->second != it2->second) return false;
+                ++it1;
+                ++it2;
+            }
+        }
+        return true;
+    }
+    
+    // Merge two mappings
+    Mapping mergeMappings(const Mapping& m1, const Mapping& m2) const {
+        Mapping merged = m1;
+        for (const auto& [key, val] : m2) {
+            merged.set(key, val);
+        }
+        return merged;
+    }
+    
+    // Check if view atom can map to query atom
+    bool canMap(const Atom& view_atom, const Atom& query_atom, 
+                Mapping& mapping) const {
+        if (view_atom.relation != query_atom.relation) return false;
+        if (view_atom.terms.size() != query_atom.terms.size()) return false;
+        
+        // Bind into a copy so a failed match leaves `mapping` untouched
+        Mapping extended = mapping;
+        
+        for (size_t i = 0; i < view_atom.terms.size(); ++i) {
+            const Term& v_term = view_atom.terms[i];
+            const Term& q_term = query_atom.terms[i];
+            
+            if (v_term.is_variable) {
+                // View variable must map consistently
+                int bound = extended.find(v_term.id);
+                if (bound == -1) {
+                    extended.set(v_term.id, q_term.id);
+                } else if (bound != q_term.id) {
+                    return false;
+                }
+            } else {
+                // View constant must match query term exactly
+                if (q_term.is_variable || v_term.id != q_term.id) {
+                    return false;
+                }
+            }
+        }
+        
+        mapping.entries.swap(extended.entries);
+        return true;
+    }
+    
+    // Precomputed seeds of each query subgoal (see SeedTable), null where
+    // findMCDs() found none; set up before MCD formation starts
+    vector<const SeedTable::Seeds*> subgoal_seeds;
+    
+    // Match every view atom over the subgoals' relations against each
+    // distinct subgoal of `queries`. Caller holds the catalog's read lock.
+    SeedTable buildSeedTable(const vector<const ConjunctiveQuery*>& queries) const {
+        SeedTable table;
+        table.version = catalog->version;
+        for (const ConjunctiveQuery* q : queries) {
+            for (const auto& atom : q->body) {
+                auto [it, inserted] = table.entries.try_emplace(SeedTable::signature(atom));
+                if (!inserted || atom.relation >= (int)catalog->atoms_by_relation.size()) {
+                    continue;
+                }
+                for (const auto& ref : catalog->atoms_by_relation[atom.relation]) {
+                    Mapping mapping;
+                    if (canMap(catalog->views[ref.view_index].body[ref.atom_index], 
+                               atom, mapping)) {
+                        it->second.push_back({ref, move(mapping)});
+                    }
+                }
+            }
+        }
+        return table;
+    }
+    
+    // Seed MCDs of view `view_idx` for subgoal `sg` from its precomputed
+    // matches, skipping atoms the interval index ruled out
+    void seedFromTable(int view_idx, int sg, const SeedTable::Seeds& seeds,
+                       vector<MCD>& out) const {
+        auto first = lower_bound(seeds.begin(), seeds.end(), view_idx,
+                                 [](const pair<ViewAtomRef, Mapping>& s, int v) {
+                                     return s.first.view_index < v;
+                                 });
+        for (auto it = first; it != seeds.end() && it->first.view_index == view_idx; ++it) {
+            if (sg < (int)range_filtered.size() && range_filtered[sg] &&
+                !binary_search(range_seeds[sg].begin(), range_seeds[sg].end(), it->first)) {
+                continue;
+            }
+            if (rangesCompatible(view_idx, it->second)) {
+                seedMCD(view_idx, sg, it->first, it->second, out);
+            }
+        }
+    }
+    
+    // Start an MCD at subgoal `sg` mapped onto view atom `ref` and extend it
+    void seedMCD(int view_idx, int sg, const ViewAtomRef& ref, const Mapping& mapping,
+                 vector<MCD>& out) const {
+        MCD mcd;
+        mcd.view_index = view_idx;
+        mcd.covered_subgoals = DynamicBitset(query.body.size());
+        mcd.covered_subgoals.set(sg);
+        mcd.variable_mapping = mapping;
+        const ConjunctiveQuery& view = catalog->views[view_idx];
+        if (view.hasOuterJoin()) {
+            mcd.view_atoms = DynamicBitset(view.body.size());
+            mcd.view_atoms.set(ref.atom_index);
+        }
+        
+        // Try to extend by covering more subgoals
+        extendMCD(view_idx, mcd, out);
+    }
+    
+    // Can the view's range predicates live with the query's under this
+    // mapping? For each mapped variable the view's interval must contain
+    // the query's (an unconstrained query variable takes a view that is
+    // unconstrained there too), or the view would lose answers. Where it
+    // is wider, the view must export the variable so the rewriting can
+    // filter it down. Checked as soon as atoms are mapped, before an MCD
+    // is extended; until the MCD is complete it is not known whether an
+    // outer-join view's ON predicates will apply (see outerJoinSafe), so
+    // a mapping survives if it works either way.
+    bool rangesCompatible(int view_idx, const Mapping& mapping) const {
+        return rangesCompatible(catalog->intervals[view_idx], view_idx, mapping) ||
+               (catalog->views[view_idx].hasOuterJoin() &&
+                rangesCompatible(catalog->matched_intervals[view_idx], view_idx, mapping));
+    }
+    
+    bool rangesCompatible(const map<int, Interval>& view_intervals, int view_idx,
+                          const Mapping& mapping) const {
+        if (view_intervals.empty() && query_intervals.empty()) return true;
+        for (const auto& [v_var, q_var] : mapping) {
+            auto v_it = view_intervals.find(v_var);
+            auto q_it = query_intervals.find(q_var);
+            Interval view_range = v_it != view_intervals.end() ? v_it->second : Interval();
+            Interval query_range = q_it != query_intervals.end() ? q_it->second : Interval();
+            if (view_range == query_range) continue;
+            if (!view_range.contains(query_range)) return false;
+            const auto& head = catalog->views[view_idx].head;
+            if (find(head.begin(), head.end(), Term(v_var, true)) == head.end()) return false;
+        }
+        return true;
+    }
+    
+    // Can an MCD over an outer-join view be used? Each nullable atom it
+    // maps needs an exported variable of its own, which the rewriting
+    // tests for NULL to drop the padded rows. The ON predicates and
+    // equalities restrict the rows the MCD sees only if it uses every
+    // nullable atom, so its ranges are rechecked against exactly the
+    // predicates that hold.
+    bool outerJoinSafe(const MCD& mcd) const {
+        const ConjunctiveQuery& view = catalog->views[mcd.view_index];
+        if (!view.hasOuterJoin()) return true;
+        bool all_used = true;
+        for (size_t a = 0; a < view.body.size(); ++a) {
+            if (!view.body[a].nullable) continue;
+            if (!mcd.view_atoms.test(a)) {
+                all_used = false;
+            } else if (view.nullTestVariable(a) == -1) {
+                return false;
+            }
+        }
+        // The ON equalities hold as well, so they cannot send their two
+        // sides to different query variables
+        if (all_used) {
+            for (const auto& [x, y] : view.on_equalities) {
+                int x_image = mcd.variable_mapping.find(x);
+                int y_image = mcd.variable_mapping.find(y);
+                if (x_image != -1 && y_image != -1 && x_image != y_image) return false;
+            }
+        }
+        const auto& ranges = all_used ? catalog->matched_intervals[mcd.view_index]
+                                      : catalog->intervals[mcd.view_index];
+        return rangesCompatible(ranges, mcd.view_index, mcd.variable_mapping);
+    }
+    
+    // Find all possible MCDs for a view and append them to `out`. Only
+    // reads shared state, so different views can be processed concurrently.
+    void findMCDsForView(int view_idx, vector<MCD>& out) const {
+        int n_subgoals = query.body.size();
+        
+        // Try to cover each query subgoal
+        for (int sg_idx = 0; sg_idx < n_subgoals; ++sg_idx) {
+            const Atom& query_atom = query.body[sg_idx];
+            if (sg_idx < (int)subgoal_seeds.size() && subgoal_seeds[sg_idx]) {
+                seedFromTable(view_idx, sg_idx, *subgoal_seeds[sg_idx], out);
+                continue;
+            }
+            
+            // Try to match with each view subgoal over the same relation
+            auto [first, last] = seedAtomsFor(sg_idx, view_idx);
+            for (auto ref = first; ref != last; ++ref) {
+                Mapping mapping;
+                if (canMap(catalog->views[view_idx].body[ref->atom_index], query_atom, mapping) && 
+                    rangesCompatible(view_idx, mapping)) {
+                    // Found a potential MCD, now extend it
+                    seedMCD(view_idx, sg_idx, *ref, mapping, out);
+                }
+            }
+        }
+    }
+    
+    // Extend MCD by covering additional subgoals. Following MiniCon's
+    // property C2, a query subgoal has to join the MCD when it shares a
+    // variable whose view preimage is existential (not in the view head);
+    // subgoals joined only through distinguished variables are left to
+    // other MCDs, which keeps MCDs minimal and lets them be combined
+    // disjointly. A forced subgoal may match several view atoms, and a
+    // choice that makes a later subgoal fail need not make the others
+    // fail, so each candidate atom is tried as a branch of its own.
+    void extendMCD(int view_idx, const MCD& mcd, vector<MCD>& out) const {
+        const ConjunctiveQuery& view = catalog->views[view_idx];
+        set<int> view_head = view.getHeadVariables();
+        
+        // Lowest uncovered subgoal forced in by an existential view variable
+        int forced_sg = -1;
+        for (size_t sg_idx = 0; sg_idx < query.body.size() && forced_sg == -1; ++sg_idx) {
+            if (mcd.covered_subgoals.test(sg_idx)) {
+                continue; // Already covered
+            }
+            for (const auto& [v_var, q_var] : mcd.variable_mapping) {
+                if (view_head.count(v_var)) continue;
+                for (const auto& q_term : query.body[sg_idx].terms) {
+                    if (q_term.is_variable && q_term.id == q_var) {
+                        forced_sg = sg_idx;
+                        break;
+                    }
+                }
+                if (forced_sg != -1) break;
+            }
+        }
+        
+        if (forced_sg != -1) {
+            // Try each view subgoal over the same relation; a forced
+            // subgoal no view atom can cover ends this branch
+            const Atom& query_atom = query.body[forced_sg];
+            auto [first, last] = viewAtomsFor(query_atom.relation, view_idx);
+            for (auto ref = first; ref != last; ++ref) {
+                MCD extended = mcd;
+                if (canMap(view.body[ref->atom_index], query_atom, extended.variable_mapping) &&
+                    rangesCompatible(view_idx, extended.variable_mapping)) {
+                    extended.covered_subgoals.set(forced_sg);
+                    if (extended.view_atoms.size()) extended.view_atoms.set(ref->atom_index);
+                    extendMCD(view_idx, extended, out);
+                }
+            }
+            return;
+        }
+        
+        MCD complete = mcd;
+        
+        // Check which distinguished variables are covered
+        for (const auto& head_term : query.head) {
+            if (head_term.is_variable) {
+                // Check if this variable is in the mapping range
+                for (const auto& [v_var, q_var] : complete.variable_mapping) {
+                    if (q_var == head_term.id && view_head.count(v_var)) {
+                        complete.distinguished_vars.insert(head_term.id);
+                        break;
+                    }
+                }
+            }
+        }
+        
+        // Only add MCD if it covers at least one subgoal and is not a
+        // duplicate reached from another seed subgoal or atom choice
+        if (complete.covered_subgoals.none()) return;
+        if (!outerJoinSafe(complete)) return;
+        for (const auto& existing : out) {
+            if (existing.view_index == complete.view_index &&
+                existing.covered_subgoals == complete.covered_subgoals &&
+                existing.variable_mapping == complete.variable_mapping &&
+                existing.view_atoms == complete.view_atoms) {
+                return;
+            }
+        }
+        out.push_back(complete);
+    }
+    
+    // Everything the cover search needs about the MCDs, precomputed once
+    // per rewrite and shared by every search over it. `compatible` is an
+    // MCD x MCD bitmatrix: bit j of row i is set when MCDs i and j cover
+    // disjoint subgoals and have consistent mappings, so the MCDs that can
+    // still join a partial cover are the AND of its members' rows.
+    struct CoverIndex {
+        vector<vector<int>> mcds_by_first_subgoal;
+        vector<DynamicBitset> compatible;
+        vector<DynamicBitset> head_coverage;  // Query head positions each MCD exports
+        bool coverable = false;     // Every subgoal is covered by some MCD
+    };
+    
+    shared_ptr<const CoverIndex> buildCoverIndex() const {
+        auto index = make_shared<CoverIndex>();
+        size_t n_subgoals = query.body.size();
+        size_t n_mcds = mcds.size();
+        index->mcds_by_first_subgoal.resize(n_subgoals);
+        
+        DynamicBitset coverable(n_subgoals);
+        for (size_t i = 0; i < n_mcds; ++i) {
+            index->mcds_by_first_subgoal[mcds[i].covered_subgoals.findFirst()].push_back(i);
+            coverable |= mcds[i].covered_subgoals;
+            
+            DynamicBitset exported(query.head.size());
+            for (size_t h = 0; h < query.head.size(); ++h) {
+                if (!query.head[h].is_variable || 
+                    mcds[i].distinguished_vars.count(query.head[h].id)) {
+                    exported.set(h);
+                }
+            }
+            index->head_coverage.push_back(exported);
+        }
+        index->coverable = n_subgoals > 0 && coverable.all();
+        if (!index->coverable) return index;
+        
+        // Rows are independent, so with a pool each one is filled whole by
+        // a single task; serially the matrix is symmetric and each pair is
+        // tested once
+        index->compatible.assign(n_mcds, DynamicBitset(n_mcds));
+        auto compatiblePair = [&](size_t i, size_t j) {
+            return !mcds[i].covered_subgoals.intersects(mcds[j].covered_subgoals) &&
+                   isConsistentMapping(mcds[i].variable_mapping, mcds[j].variable_mapping);
+        };
+        if (pool) {
+            pool->parallelFor(n_mcds, [&](size_t i, unsigned) {
+                for (size_t j = 0; j < n_mcds; ++j) {
+                    if (j != i && compatiblePair(i, j)) index->compatible[i].set(j);
+                }
+            });
+        } else {
+            for (size_t i = 0; i < n_mcds; ++i) {
+                for (size_t j = i + 1; j < n_mcds; ++j) {
+                    if (compatiblePair(i, j)) {
+                        index->compatible[i].set(j);
+                        index->compatible[j].set(i);
+                    }
+                }
+            }
+        }
+        return index;
+    }
+    
+    // MCDs compatible with every MCD in `chosen`
+    static DynamicBitset allowedAfter(const CoverIndex& index, const vector<int>& chosen) {
+        DynamicBitset allowed(index.compatible.size());
+        allowed.setAll();
+        for (int c : chosen) allowed &= index.compatible[c];
+        return allowed;
+    }
+    
+    // Final check on a complete cover: every head variable of the query
+    // must be exported by some MCD. Subgoal disjointness and mapping
+    // consistency are already enforced while the cover is built.
+    bool isValidRewriting(const CoverIndex& index, const vector<int>& chosen) const {
+        DynamicBitset exported(query.head.size());
+        for (int m : chosen) exported |= index.head_coverage[m];
+        return exported.all();
+    }
+    
+    // Pull-based depth-first exact-cover search. Each level takes the
+    // lowest uncovered subgoal and branches only over MCDs whose lowest
+    // subgoal it is (any other MCD covering it would overlap the cover
+    // built so far); a branch is dropped as soon as a mapping conflicts or
+    // the subgoal has no usable MCD left. next() resumes where the last
+    // call stopped and yields one rewriting at a time, so callers that
+    // want only the first few never pay for the rest. A generator reads
+    // the MiniCon's MCDs and must not outlive the next rewrite().
+    class RewritingGenerator {
+    public:
+        RewritingGenerator(const MiniCon& owner, shared_ptr<const CoverIndex> idx,
+                           vector<int> prefix, DynamicBitset prefix_covered)
+            : mc(&owner), index(move(idx)), chosen(move(prefix)),
+              covered(move(prefix_covered)), exhausted(!index->coverable) {
+            if (!exhausted) allowed.push_back(allowedAfter(*index, chosen));
+        }
+        
+        // Produce the next rewriting in DFS order; false once exhausted
+        bool next(QueryRewriting& out) {
+            if (exhausted) return false;
+            if (!started) {
+                started = true;
+                if (enterNode(out)) return true;
+            }
+            while (!frames.empty()) {
+                Frame& frame = frames.back();
+                if (frame.taken != -1) {
+                    chosen.pop_back();
+                    covered.subtract(mc->mcds[frame.taken].covered_subgoals);
+                    allowed.pop_back();
+                    frame.taken = -1;
+                }
+                
+                const auto& branches = index->mcds_by_first_subgoal[frame.subgoal];
+                while (frame.pos < branches.size()) {
+                    int m = branches[frame.pos++];
+                    if (!allowed.back().test(m)) continue;
+                    chosen.push_back(m);
+                    covered |= mc->mcds[m].covered_subgoals;
+                    allowed.push_back(allowed.back());
+                    allowed.back() &= index->compatible[m];
+                    frame.taken = m;
+                    break;
+                }
+                if (frame.taken == -1) {
+                    frames.pop_back();
+                    continue;
+                }
+                if (enterNode(out)) return true;
+            }
+            exhausted = true;
+            return false;
+        }
+        
+    private:
+        struct Frame {
+            int subgoal;        // Lowest uncovered subgoal at this level
+            size_t pos;         // Next branch to try for it
+            int taken;          // MCD currently chosen at this level, or -1
+        };
+        
+        // Visit the node reached by `chosen`: a complete cover is reported
+        // through `out`, anything else opens a new level
+        bool enterNode(QueryRewriting& out) {
+            int sg = covered.findFirstUnset();
+            if (sg != -1) {
+                frames.push_back({sg, 0, -1});
+                return false;
+            }
+            if (!mc->isValidRewriting(*index, chosen)) return false;
+            out.view_indices.clear();
+            out.mappings.clear();
+            for (int m : chosen) {
+                out.view_indices.push_back(mc->mcds[m].view_index);
+                out.mappings.push_back(mc->mcds[m].variable_mapping);
+            }
+            mc->setViewAtoms(out, chosen);
+            out.covered_subgoals = covered;
+            return true;
+        }
+        
+        const MiniCon* mc;
+        shared_ptr<const CoverIndex> index;
+        vector<int> chosen;
+        DynamicBitset covered;
+        vector<DynamicBitset> allowed;  // Compatible MCDs after each level
+        vector<Frame> frames;
+        bool started = false;
+        bool exhausted;
+    };
+    
+    // Generator over all rewritings of the MCDs found by the last findMCDs()
+    RewritingGenerator generator() const {
+        return RewritingGenerator(*this, buildCoverIndex(), {}, 
+                                  DynamicBitset(query.body.size()));
+    }
+    
+    // The parallel search expands this many levels into separate tasks
+    // before each task finishes its subtree with the serial search
+    static constexpr size_t COVER_SPLIT_DEPTH = 2;
+    
+    // A subtree of the cover search. `path` is the branch position taken
+    // at each level, so sorting results by path restores serial DFS order.
+    struct CoverTask {
+        vector<int> chosen;
+        DynamicBitset covered;
+        vector<int> path;
+    };
+    
+    // Run the cover search on the work-stealing scheduler. Each worker
+    // appends (path, rewritings) to its own buffer; the buffers are merged
+    // and sorted by path so the output matches the serial search exactly.
+    void searchCoversParallel(shared_ptr<const CoverIndex> index,
+                              vector<QueryRewriting>& rewritings) const {
+        using PathResults = pair<vector<int>, vector<QueryRewriting>>;
+        WorkStealingScheduler scheduler(*pool);
+        vector<vector<PathResults>> worker_results(pool->size());
+        
+        function<void(CoverTask&, unsigned)> run_task =
+            [&](CoverTask& task, unsigned worker) {
+            int sg = task.covered.findFirstUnset();
+            if (sg == -1 || task.path.size() >= COVER_SPLIT_DEPTH) {
+                vector<QueryRewriting> found;
+                RewritingGenerator gen(*this, index, move(task.chosen), 
+                                       move(task.covered));
+                QueryRewriting rewriting;
+                while (gen.next(rewriting)) found.push_back(rewriting);
+                if (!found.empty()) {
+                    worker_results[worker].push_back({move(task.path), move(found)});
+                }
+                return;
+            }
+            const auto& branches = index->mcds_by_first_subgoal[sg];
+            DynamicBitset allowed = allowedAfter(*index, task.chosen);
+            for (size_t b = 0; b < branches.size(); ++b) {
+                int m = branches[b];
+                if (!allowed.test(m)) continue;
+                CoverTask child = task;
+                child.chosen.push_back(m);
+                child.covered |= mcds[m].covered_subgoals;
+                child.path.push_back(b);
+                scheduler.spawn(worker, [&run_task, child = move(child)](unsigned w) mutable {
+                    run_task(child, w);
+                });
+            }
+        };
+        
+        CoverTask root{{}, DynamicBitset(query.body.size()), {}};
+        scheduler.run([&](unsigned worker) { run_task(root, worker); });
+        
+        vector<PathResults> merged;
+        for (auto& results : worker_results) {
+            for (auto& r : results) merged.push_back(move(r));
+        }
+        sort(merged.begin(), merged.end(),
+             [](const PathResults& x, const PathResults& y) { return x.first < y.first; });
+        for (auto& r : merged) {
+            for (auto& rw : r.second) rewritings.push_back(move(rw));
+        }
+    }
+    
+    // Join one more view occurrence into `est`. The result size follows the
+    // textbook estimate |A join B| = |A||B| / prod max(V(A,x), V(B,x)) over
+    // the query variables x the two sides share.
+    JoinEstimate joinView(const JoinEstimate& est, int view_idx, 
+                          const Mapping& mapping) const {
+        const ViewStatistics& stats = catalog->stats[view_idx];
+        const ConjunctiveQuery& view = catalog->views[view_idx];
+        
+        // Query variables this occurrence exposes, with their distinct counts
+        map<int, double> exposed;
+        double view_width = 0;
+        for (const auto& head_term : view.head) {
+            view_width += stats.width(head_term.id);
+            int q_var = mapping.find(head_term.id);
+            if (q_var == -1) continue;
+            double d = stats.distinct(head_term.id);
+            auto it = exposed.find(q_var);
+            exposed[q_var] = it == exposed.end() ? d : min(it->second, d);
+        }
+        
+        JoinEstimate joined;
+        joined.empty = false;
+        joined.width = est.width + view_width;
+        if (est.empty) {
+            joined.rows = stats.row_count;
+        } else {
+            double denominator = 1;
+            for (const auto& [q_var, d] : exposed) {
+                auto it = est.distinct.find(q_var);
+                if (it != est.distinct.end()) denominator *= max(max(it->second, d), 1.0);
+            }
+            joined.rows = est.rows * stats.row_count / denominator;
+        }
+        
+        joined.distinct = est.distinct;
+        for (const auto& [q_var, d] : exposed) {
+            auto it = joined.distinct.find(q_var);
+            joined.distinct[q_var] = it == joined.distinct.end() ? d : min(it->second, d);
+        }
+        for (auto& [q_var, d] : joined.distinct) d = min(d, max(joined.rows, 1.0));
+        
+        joined.cost = est.cost + stats.row_count * view_width;
+        if (!est.empty) joined.cost += joined.rows * joined.width;
+        return joined;
+    }
+    
+    double estimateCost(const QueryRewriting& rewriting) const {
+        JoinEstimate est;
+        for (size_t i = 0; i < rewriting.view_indices.size(); ++i) {
+            est = joinView(est, rewriting.view_indices[i], rewriting.mappings[i]);
+        }
+        return est.cost;
+    }
+    
+    // Fill in each rewriting's cost and order them cheapest first (ties
+    // keep their search order)
+    void rankRewritings(vector<QueryRewriting>& rewritings) const {
+        for (auto& rw : rewritings) rw.cost = estimateCost(rw);
+        stable_sort(rewritings.begin(), rewritings.end(),
+                    [](const QueryRewriting& a, const QueryRewriting& b) {
+                        return a.cost < b.cost;
+                    });
+    }
+    
+    // Branch-and-bound cover search: same branching as the generator, but
+    // a prefix whose estimate already reaches the best complete cost is
+    // cut, since adding views can only increase the estimate
+    void searchCheapest(const CoverIndex& index, vector<int>& chosen,
+                        DynamicBitset& covered, const DynamicBitset& allowed,
+                        const JoinEstimate& est,
+                        vector<int>& best, double& best_cost) const {
+        if (!best.empty() && est.cost >= best_cost) return;
+        int sg = covered.findFirstUnset();
+        if (sg == -1) {
+            if (isValidRewriting(index, chosen)) {
+                best = chosen;
+                best_cost = est.cost;
+            }
+            return;
+        }
+        for (int m : index.mcds_by_first_subgoal[sg]) {
+            if (!allowed.test(m)) continue;
+            JoinEstimate next = joinView(est, mcds[m].view_index, mcds[m].variable_mapping);
+            DynamicBitset next_allowed = allowed;
+            next_allowed &= index.compatible[m];
+            covered |= mcds[m].covered_subgoals;
+            chosen.push_back(m);
+            searchCheapest(index, chosen, covered, next_allowed, next, best, best_cost);
+            chosen.pop_back();
+            covered.subtract(mcds[m].covered_subgoals);
+        }
+    }
+    
+    // Enumerate covers with Algorithm X over the MCD x subgoal matrix. The
+    // covers are collected as MCD sets and put in the order the
+    // backtracking search would produce them: each cover sorted by lowest
+    // subgoal, then covers compared lexicographically.
+    void searchCoversDLX(const CoverIndex& index, vector<QueryRewriting>& rewritings) const {
+        vector<vector<int>> rows;
+        for (const auto& mcd : mcds) {
+            rows.emplace_back();
+            for (int sg : mcd.covered_subgoals) rows.back().push_back(sg);
+        }
+        
+        vector<vector<int>> covers;
+        DancingLinks dlx(query.body.size(), rows, index.compatible);
+        dlx.search([&](const vector<int>& chosen) {
+            if (isValidRewriting(index, chosen)) covers.push_back(chosen);
+        });
+        
+        for (auto& cover : covers) {
+            sort(cover.begin(), cover.end(), [&](int a, int b) {
+                return mcds[a].covered_subgoals.findFirst() < mcds[b].covered_subgoals.findFirst();
+            });
+        }
+        sort(covers.begin(), covers.end());
+        
+        for (const auto& cover : covers) {
+            QueryRewriting rw;
+            rw.covered_subgoals = DynamicBitset(query.body.size());
+            for (int m : cover) {
+                rw.view_indices.push_back(mcds[m].view_index);
+                rw.mappings.push_back(mcds[m].variable_mapping);
+                rw.covered_subgoals |= mcds[m].covered_subgoals;
+            }
+            setViewAtoms(rw, cover);
+            rewritings.push_back(move(rw));
+        }
+    }
+    
+    // Record which view atoms each occurrence of a cover uses, if any of
+    // its MCDs is over an outer-join view
+    void setViewAtoms(QueryRewriting& rw, const vector<int>& cover) const {
+        rw.view_atoms.clear();
+        for (int m : cover) {
+            if (mcds[m].view_atoms.size() == 0) continue;
+            for (int n : cover) rw.view_atoms.push_back(mcds[n].view_atoms);
+            return;
+        }
+    }
+    
+    // Combine MCDs with pairwise disjoint subgoals into rewritings
+    void generateRewritings(vector<QueryRewriting>& rewritings) {
+        auto index = buildCoverIndex();
+        // A subgoal no MCD covers rules out every rewriting up front
+        if (!index->coverable) return;
+        
+        if (cover_engine == CoverEngine::DancingLinks) {
+            searchCoversDLX(*index, rewritings);
+        } else if (pool) {
+            searchCoversParallel(index, rewritings);
+        } else {
+            RewritingGenerator gen(*this, index, {}, DynamicBitset(query.body.size()));
+            QueryRewriting rewriting;
+            while (gen.next(rewriting)) rewritings.push_back(rewriting);
+        }
+        if (prune_redundant) pruneRedundantRewritings(rewritings);
+    }
+    
+    // Drop rewritings that contribute nothing to the union: those contained
+    // in another rewriting, and among equivalent ones all but the one with
+    // the fewest view occurrences (the earliest on ties)
+    bool prune_redundant = true;
+    
+    // Unfold a rewriting into base relations. Each view occurrence
+    // contributes its body, with head variables replaced by their query
+    // images and every other variable (existential, or a head variable the
+    // MCD leaves unmapped) renamed to a fresh ID beyond the symbol table.
+    // An outer-join view unfolds to the rows its occurrence can see: the
+    // nullable atoms it does not use drop out (their partners' rows are
+    // all preserved), the ones it uses join as inner (the rewriting tests
+    // them for NULL), and the ON predicates and equalities hold only if
+    // nothing dropped.
+    ConjunctiveQuery expandRewriting(const QueryRewriting& rw) const {
+        ConjunctiveQuery expansion(query.name);
+        expansion.symbols = catalog->symbols;
+        expansion.head = query.head;
+        int next_fresh = catalog->symbols->size();
+        for (size_t i = 0; i < rw.view_indices.size(); ++i) {
+            const ConjunctiveQuery& view = catalog->views[rw.view_indices[i]];
+            set<int> view_head = view.getHeadVariables();
+            bool dropped = false;
+            for (size_t a = 0; a < view.body.size(); ++a) {
+                if (view.body[a].nullable && !rw.usesAtom(i, a)) dropped = true;
+            }
+            // ON equalities that hold: each side stands for the other,
+            // preferring the one with a query image
+            map<int, int> merged;
+            if (!dropped) {
+                for (const auto& [x, y] : view.on_equalities) {
+                    bool y_mapped = view_head.count(y) && rw.mappings[i].find(y) != -1;
+                    if (y_mapped) merged[x] = y; else merged[y] = x;
+                }
+            }
+            map<int, int> fresh;
+            auto imageOf = [&](int var) {
+                auto m = merged.find(var);
+                if (m != merged.end()) var = m->second;
+                int image = view_head.count(var) ? rw.mappings[i].find(var) : -1;
+                if (image != -1) return image;
+                auto it = fresh.find(var);
+                return it != fresh.end() ? it->second : (fresh[var] = next_fresh++);
+            };
+            set<int> kept_vars;
+            for (size_t a = 0; a < view.body.size(); ++a) {
+                const Atom& view_atom = view.body[a];
+                if (view_atom.nullable && !rw.usesAtom(i, a)) continue;
+                Atom atom(view_atom.relation);
+                for (const auto& t : view_atom.terms) {
+                    atom.addTerm(t.is_variable ? Term(imageOf(t.id), true) : t);
+                    if (t.is_variable) kept_vars.insert(t.id);
+                }
+                expansion.body.push_back(atom);
+            }
+            for (const auto& c : view.comparisons) {
+                if (c.conditional && dropped) continue;
+                if (!kept_vars.count(c.var)) continue;
+                expansion.comparisons.push_back({imageOf(c.var), c.op, c.value});
+            }
+        }
+        
+        // The rewriting applies the query's range predicates on top (see
+        // rangesCompatible for why every one of them can be applied)
+        set<int> vars = expansion.getVariables();
+        for (const auto& c : query.comparisons) {
+            if (vars.count(c.var)) expansion.comparisons.push_back(c);
+        }
+        return expansion;
+    }
+    
+    // Remove view occurrences that repeat an earlier one: same view and the
+    // same image for every head variable (and, for outer-join views, the
+    // same atoms used). The repeated atom adds a self-join that cannot
+    // change the answer.
+    void collapseDuplicateOccurrences(QueryRewriting& rw) const {
+        vector<tuple<int, vector<int>, DynamicBitset>> seen;
+        QueryRewriting collapsed;
+        collapsed.covered_subgoals = rw.covered_subgoals;
+        collapsed.cost = rw.cost;
+        for (size_t i = 0; i < rw.view_indices.size(); ++i) {
+            const ConjunctiveQuery& view = catalog->views[rw.view_indices[i]];
+            tuple<int, vector<int>, DynamicBitset> key{
+                rw.view_indices[i], {}, i < rw.view_atoms.size() ? rw.view_atoms[i] : DynamicBitset()};
+            for (const auto& t : view.head) get<1>(key).push_back(rw.mappings[i].find(t.id));
+            if (find(seen.begin(), seen.end(), key) != seen.end()) continue;
+            seen.push_back(key);
+            collapsed.view_indices.push_back(rw.view_indices[i]);
+            collapsed.mappings.push_back(rw.mappings[i]);
+            if (!rw.view_atoms.empty()) collapsed.view_atoms.push_back(rw.view_atoms[i]);
+        }
+        rw = collapsed;
+    }
+    
+    // Relations used by an expansion; q1 can only be contained in q2 if
+    // q2 uses no relation q1 lacks, which rules out most pairs cheaply
+    static vector<int> relationsOf(const ConjunctiveQuery& q) {
+        vector<int> rels;
+        for (const auto& atom : q.body) rels.push_back(atom.relation);
+        sort(rels.begin(), rels.end());
+        rels.erase(unique(rels.begin(), rels.end()), rels.end());
+        return rels;
+    }
+    
+    void pruneRedundantRewritings(vector<QueryRewriting>& rewritings) const {
+        size_t n = rewritings.size();
+        vector<ConjunctiveQuery> expansions;
+        vector<vector<int>> relations;
+        for (auto& rw : rewritings) {
+            collapseDuplicateOccurrences(rw);
+            expansions.push_back(expandRewriting(rw));
+            relations.push_back(relationsOf(expansions.back()));
+        }
+        
+        // Does rewriting i have to give way to rewriting j?
+        auto dominatedBy = [&](size_t i, size_t j) {
+            if (!includes(relations[i].begin(), relations[i].end(),
+                          relations[j].begin(), relations[j].end())) {
+                return false;
+            }
+            if (!isContainedIn(expansions[i], expansions[j])) return false;
+            if (!isContainedIn(expansions[j], expansions[i])) return true;
+            size_t size_i = rewritings[i].view_indices.size();
+            size_t size_j = rewritings[j].view_indices.size();
+            return size_j < size_i || (size_j == size_i && j < i);
+        };
+        
+        // Containment is transitive, so it suffices to compare each
+        // rewriting with the current survivors only
+        vector<size_t> kept;
+        for (size_t i = 0; i < n; ++i) {
+            bool dominated = false;
+            for (size_t j : kept) {
+                if (dominatedBy(i, j)) { dominated = true; break; }
+            }
+            if (dominated) continue;
+            kept.erase(remove_if(kept.begin(), kept.end(),
+                                 [&](size_t j) { return dominatedBy(j, i); }),
+                       kept.end());
+            kept.push_back(i);
+        }
+        
+        sort(kept.begin(), kept.end());
+        vector<QueryRewriting> survivors;
+        for (size_t i : kept) survivors.push_back(move(rewritings[i]));
+        rewritings = move(survivors);
+    }
+    
+    // Rewritings of an aggregate query. These must be equivalent to the
+    // query and keep its row multiplicities, which SUM and COUNT see, so
+    // the covers MiniCon finds over plain views are kept only if their
+    // expansion has exactly the query's atoms and contains the query;
+    // they are then aggregated again. Aggregate views are matched on their
+    // own, one view per rewriting.
+    void aggregateRewritings(vector<QueryRewriting>& rewritings) {
+        bool was_pruning = prune_redundant;
+        prune_redundant = false;
+        vector<QueryRewriting> covers;
+        generateRewritings(covers);
+        prune_redundant = was_pruning;
+        for (auto& rw : covers) {
+            if (reaggregate(rw)) rewritings.push_back(move(rw));
+        }
+        aggregateViewRewritings(rewritings);
+    }
+    
+    bool reaggregate(QueryRewriting& rw) const {
+        for (int v : rw.view_indices) {
+            const ConjunctiveQuery& view = catalog->views[v];
+            // One row per group, or outer-join rows repeated per match
+            if (view.isAggregate() || view.hasOuterJoin()) return false;
+        }
+        collapseDuplicateOccurrences(rw);
+        ConjunctiveQuery expansion = expandRewriting(rw);
+        if (expansion.body.size() != query.body.size() || !isContainedIn(query, expansion)) {
+            return false;
+        }
+        rw.aggregate_terms.clear();
+        for (const auto& agg : query.aggregates) {
+            AggregateTerm term{agg.op, 0, -1};
+            // MiniCon made every aggregated variable a head variable, so
+            // some occurrence exports it
+            for (size_t i = 0; i < rw.view_indices.size() && term.var == -1; ++i) {
+                for (const auto& t : catalog->views[rw.view_indices[i]].head) {
+                    if (agg.arg != -1 && rw.mappings[i].find(t.id) == agg.arg) {
+                        term.occurrence = i;
+                        term.var = t.id;
+                        break;
+                    }
+                }
+            }
+            if (agg.arg != -1 && term.var == -1) return false;
+            rw.aggregate_terms.push_back(term);
+        }
+        rw.regroup = true;
+        return true;
+    }
+    
+    // Single-view rewritings from aggregate views. The view body must be
+    // the query body up to a renaming of variables, so each view group
+    // holds the same base rows with the same multiplicities.
+    void aggregateViewRewritings(vector<QueryRewriting>& rewritings) const {
+        for (size_t v = 0; v < catalog->views.size(); ++v) {
+            const ConjunctiveQuery& view = catalog->views[v];
+            if (!catalog->isLive(v) || !view.isAggregate() || view.hasOuterJoin() ||
+                view.body.size() != query.body.size()) {
+                continue;
+            }
+            vector<bool> used(view.body.size(), false);
+            QueryRewriting rw;
+            if (matchAggregateView(v, 0, used, Mapping(), rw)) rewritings.push_back(move(rw));
+        }
+    }
+    
+    // Match query subgoals sg.. to unused view atoms, keeping the mapping a
+    // renaming (injective, variables onto variables); the first renaming
+    // that rolls up wins
+    bool matchAggregateView(int view_idx, size_t sg, vector<bool>& used,
+                            const Mapping& renaming, QueryRewriting& rw) const {
+        const ConjunctiveQuery& view = catalog->views[view_idx];
+        if (sg == query.body.size()) return rollUp(view_idx, renaming, rw);
+        const Atom& query_atom = query.body[sg];
+        for (size_t a = 0; a < view.body.size(); ++a) {
+            const Atom& view_atom = view.body[a];
+            if (used[a] || view_atom.terms.size() != query_atom.terms.size()) continue;
+            bool same_kinds = true;
+            for (size_t pos = 0; pos < view_atom.terms.size(); ++pos) {
+                same_kinds &= view_atom.terms[pos].is_variable == query_atom.terms[pos].is_variable;
+            }
+            Mapping extended = renaming;
+            if (!same_kinds || !canMap(view_atom, query_atom, extended)) continue;
+            vector<int> images;
+            for (const auto& [v_var, q_var] : extended) images.push_back(q_var);
+            sort(images.begin(), images.end());
+            if (adjacent_find(images.begin(), images.end()) != images.end()) continue;
+            used[a] = true;
+            bool found = matchAggregateView(view_idx, sg + 1, used, extended, rw);
+            used[a] = false;
+            if (found) return true;
+        }
+        return false;
+    }
+    
+    // Can the query's aggregates be computed from the view renamed by
+    // `renaming`? Each variable's view range must equal the query's, or be
+    // wider on an exported column the rewriting filters before grouping
+    // again. The query's groups must be unions of view groups. SUM and
+    // COUNT roll up by summing the view's SUM or COUNT, MIN and MAX by
+    // themselves; MIN, MAX and SUM of a view grouping column come from the
+    // column itself (SUM weighted by the view's COUNT(*)).
+    bool rollUp(int view_idx, const Mapping& renaming, QueryRewriting& rw) const {
+        const ConjunctiveQuery& view = catalog->views[view_idx];
+        set<int> exported = view.getHeadVariables();
+        const auto& view_intervals = catalog->intervals[view_idx];
+        for (const auto& [v_var, q_var] : renaming) {
+            auto v_it = view_intervals.find(v_var);
+            auto q_it = query_intervals.find(q_var);
+            Interval view_range = v_it != view_intervals.end() ? v_it->second : Interval();
+            Interval query_range = q_it != query_intervals.end() ? q_it->second : Interval();
+            if (view_range == query_range) continue;
+            if (!exported.count(v_var) || !view_range.contains(query_range)) return false;
+        }
+        
+        auto viewColumn = [&](int q_var) {
+            for (int v_var : exported) {
+                if (renaming.find(v_var) == q_var) return v_var;
+            }
+            return -1;
+        };
+        set<int> query_groups(query.group_by.begin(), query.group_by.end());
+        set<int> view_groups;
+        for (int g : view.group_by) view_groups.insert(renaming.find(g));
+        for (int g : query_groups) {
+            if (viewColumn(g) == -1) return false;
+        }
+        
+        int view_count = -1;
+        for (const auto& v_agg : view.aggregates) {
+            if (v_agg.op == AggregateOp::Count && v_agg.arg == -1) view_count = v_agg.output;
+        }
+        vector<AggregateTerm> terms;
+        for (const auto& agg : query.aggregates) {
+            AggregateTerm term{agg.op == AggregateOp::Count ? AggregateOp::Sum : agg.op, 0, -1};
+            for (const auto& v_agg : view.aggregates) {
+                bool same_arg = agg.arg == -1 ? v_agg.arg == -1 
+                                              : v_agg.arg != -1 && renaming.find(v_agg.arg) == agg.arg;
+                if (v_agg.op == agg.op && same_arg) {
+                    term.var = v_agg.output;
+                    break;
+                }
+            }
+            if (term.var == -1 && agg.arg != -1 && agg.op != AggregateOp::Count) {
+                term.var = viewColumn(agg.arg);
+                if (agg.op == AggregateOp::Sum) {
+                    if (view_count == -1) term.var = -1;
+                    term.weight = view_count;
+                }
+            }
+            if (term.var == -1) return false;
+            terms.push_back(term);
+        }
+        
+        rw = QueryRewriting();
+        rw.view_indices = {view_idx};
+        rw.mappings = {renaming};
+        rw.covered_subgoals = DynamicBitset(query.body.size());
+        rw.covered_subgoals.setAll();
+        rw.aggregate_terms = move(terms);
+        rw.regroup = view_groups != query_groups;
+        return true;
+    }
+    
+private:
+    // Candidate views of the last query, with the relations and catalog
+    // version they were computed for
+    vector<int> candidates;
+    vector<int> candidate_relations;
+    uint64_t candidate_version = UINT64_MAX;
+    
+public:
+    ConjunctiveQuery query_cq; // Store original query for SQL output
+    map<int, Interval> query_intervals;     // Range of each compared query variable
+    
+    // Worker pool for MCD formation and the cover search; unset means serial
+    shared_ptr<ThreadPool> pool;
+    
+    void setThreads(unsigned n_threads) {
+        pool = n_threads > 1 ? make_shared<ThreadPool>(n_threads) : nullptr;
+    }
+    
+    // Rewrite the core of the query instead of the query as written, so
+    // redundant subgoals never reach MCD formation
+    bool minimize_query = true;
+    
+    // Returns false, leaving the previous query in place, for a query
+    // converted with another symbol table or one with an outer join
+    bool setQuery(const ConjunctiveQuery& q) {
+        if (!catalog->usesSymbols(q)) return false;
+        if (q.hasOuterJoin()) {
+            cerr << "MiniCon: " << q.name 
+                 << " has an outer join; only views may use them\n";
+            return false;
+        }
+        // Dropping a redundant subgoal would change the multiplicities an
+        // aggregate sees
+        query = minimize_query && !q.isAggregate() ? minimizeQuery(q) : q;
+        if (q.isAggregate()) {
+            // MiniCon has to deliver the grouping and aggregated columns
+            // too; query_cq keeps the output head
+            auto addHead = [&](int var) {
+                if (var == -1) return;
+                if (find(query.head.begin(), query.head.end(), Term(var, true)) == query.head.end()) {
+                    query.head.push_back(Term(var, true));
+                }
+            };
+            for (int var : q.group_by) addHead(var);
+            for (const auto& agg : q.aggregates) addHead(agg.arg);
+        }
+        query_cq = q;
+        query_intervals = query.intervals();
+        if (verbose && query.body.size() < q.body.size()) {
+            cout << "Minimized query: removed " 
+                 << q.body.size() - query.body.size() << " redundant subgoal(s)\n";
+        }
+        return true;
+    }
+    
+    // How complete rewrites enumerate covers. Backtracking is the lowest-
+    // uncovered-subgoal search (parallel when a pool is set); DancingLinks
+    // runs Algorithm X, branching on the subgoal with the fewest live MCDs.
+    // Both return the same rewritings in the same order. Limited rewrites
+    // always stream from the backtracking generator.
+    enum class CoverEngine { Backtracking, DancingLinks };
+    CoverEngine cover_engine = CoverEngine::Backtracking;
+    
+    // Trace MCD formation and the search steps on stdout
+    bool verbose = true;
+    
+    // Seed matches of the query group being rewritten by rewriteBatch();
+    // ignored once the catalog has changed since it was built
+    shared_ptr<const SeedTable> seed_table;
+    
+    // Optional cache of complete rewrite() results
+    shared_ptr<RewritingCache> cache;
+    
+    void setCache(size_t capacity) {
+        cache = capacity > 0 ? make_shared<RewritingCache>(capacity) : nullptr;
+    }
+    
+    int addView(const ConjunctiveQuery& v, 
+                const ViewStatistics& stats = ViewStatistics()) {
+        return catalog->addView(v, stats);
+    }
+    
+    void setViewStatistics(int view_idx, const ViewStatistics& stats) {
+        catalog->setViewStatistics(view_idx, stats);
+    }
+    
+    // Step 1 of rewrite(): form the MCDs of every candidate view
+    void findMCDs() {
+        mcds.clear();
+        
+        // Find all MCDs; views sharing no relation with the query are
+        // skipped. Consecutive queries over the same relations (as
+        // rewriteBatch() orders them) reuse the candidate list.
+        vector<int> relations;
+        for (const auto& atom : query.body) relations.push_back(atom.relation);
+        sort(relations.begin(), relations.end());
+        relations.erase(unique(relations.begin(), relations.end()), relations.end());
+        subgoal_seeds.assign(query.body.size(), nullptr);
+        if (seed_table && seed_table->version == catalog->version) {
+            for (size_t sg = 0; sg < query.body.size(); ++sg) {
+                subgoal_seeds[sg] = seed_table->find(query.body[sg]);
+            }
+        }
+        if (filterSeedsByRange()) {
+            candidates = candidateViews();
+            candidate_version = UINT64_MAX;
+        } else if (relations != candidate_relations || catalog->version != candidate_version) {
+            candidates = candidateViews();
+            candidate_relations = relations;
+            candidate_version = catalog->version;
+        }
+        
+        if (verbose) {
+            cout << "\n=== Step 1: Finding MCDs for each view ===\n";
+            for (int i : candidates) {
+                cout << "\nProcessing View " << i << ": " 
+                         << catalog->views[i].toString() << "\n";
+            }
+        }
+        
+        // Each view fills its own buffer; concatenating the buffers in view
+        // order keeps the MCD list identical to the serial path
+        vector<vector<MCD>> view_mcds(candidates.size());
+        if (pool) {
+            pool->parallelFor(candidates.size(), [&](size_t k, unsigned) {
+                findMCDsForView(candidates[k], view_mcds[k]);
+            });
+        } else {
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                findMCDsForView(candidates[k], view_mcds[k]);
+            }
+        }
+        for (auto& buffer : view_mcds) {
+            for (auto& mcd : buffer) mcds.push_back(move(mcd));
+        }
+        
+        if (verbose) printMCDs();
+    }
+    
+    void printMCDs() const {
+        cout << "\nFound " << mcds.size() << " MCDs:\n";
+        for (size_t i = 0; i < mcds.size(); ++i) {
+            cout << "  MCD " << i << ": View V" << mcds[i].view_index 
+                     << " covers subgoals {";
+            bool first = true;
+            for (int sg : mcds[i].covered_subgoals) {
                 if (!first) cout << ", ";
                 cout << sg;
                 first = false;
             }
-            cout << "}\n    Mapping: {";
-            first = true;
-            for (const auto& [v, q] : mcds[i].variable_mapping) {
-                if (!first) cout << ", ";
-                cout << v << "->" << q;
-                first = false;
+            cout << "}\n    Mapping: {";
+            first = true;
+            for (const auto& [v, q] : mcds[i].variable_mapping) {
+                if (!first) cout << ", ";
+                cout << catalog->symbols->name(v) << "->" << catalog->symbols->name(q);
+                first = false;
+            }
+            cout << "}\n    Distinguished vars: {";
+            first = true;
+            for (const auto& dv : mcds[i].distinguished_vars) {
+                if (!first) cout << ", ";
+                cout << catalog->symbols->name(dv);
+                first = false;
+            }
+            cout << "}\n";
+        }
+    }
+    
+    static constexpr size_t NO_LIMIT = SIZE_MAX;
+    
+    // Rewrite the query, stopping once `limit` rewritings are found. A
+    // complete rewrite ranks its rewritings cheapest first under the cost
+    // model. A limited search always runs the serial generator so it
+    // returns the first rewritings in DFS order (with their costs filled
+    // in) and stops exploring right there; rewriteCheapest() finds the
+    // best one without enumerating the rest.
+    //
+    // With a cache set, a complete rewrite of a query whose canonical form
+    // was already rewritten against this catalog version, under the same
+    // settings (see cacheKey), is answered from the cache without forming
+    // MCDs (`mcds` is then left as it was). Limited rewrites bypass it.
+    vector<QueryRewriting> rewrite(size_t limit = NO_LIMIT) {
+        auto lock = catalog->readLock();
+        vector<QueryRewriting> rewritings;
+        CanonicalQuery canon;
+        string cache_key;
+        if (cache && limit == NO_LIMIT) {
+            canon = canonicalize(query);
+            cache_key = cacheKey(canon);
+            vector<CachedRewriting> cached;
+            if (cache->lookup(cache_key, cached)) {
+                if (verbose) cout << "\n=== Rewritings served from cache ===\n";
+                for (const auto& c : cached) {
+                    rewritings.push_back(fromCanonical(c, canon));
+                }
+                return rewritings;
+            }
+        }
+        
+        findMCDs();
+        
+        if (verbose) cout << "\n=== Step 2: Combining MCDs to form rewritings ===\n";
+        // Generate rewritings (aggregate rewritings are filtered after the
+        // search, so they are never streamed)
+        if (limit == NO_LIMIT || query.isAggregate()) {
+            if (query.isAggregate()) {
+                aggregateRewritings(rewritings);
+            } else {
+                generateRewritings(rewritings);
+            }
+            rankRewritings(rewritings);
+            if (rewritings.size() > limit) rewritings.resize(limit);
+            if (cache && limit == NO_LIMIT) {
+                vector<CachedRewriting> entry;
+                for (const auto& rw : rewritings) entry.push_back(toCanonical(rw, canon));
+                cache->insert(cache_key, move(entry));
+            }
+            return rewritings;
+        }
+        // Streaming cannot take back what it already returned, so here a
+        // rewriting is only dropped if an earlier one already contains it
+        RewritingGenerator gen = generator();
+        QueryRewriting rewriting;
+        vector<ConjunctiveQuery> expansions;
+        while (rewritings.size() < limit && gen.next(rewriting)) {
+            if (prune_redundant) {
+                collapseDuplicateOccurrences(rewriting);
+                ConjunctiveQuery expansion = expandRewriting(rewriting);
+                bool redundant = false;
+                for (size_t i = 0; i < expansions.size() && !redundant; ++i) {
+                    redundant = isContainedIn(expansion, expansions[i]);
+                }
+                if (redundant) continue;
+                expansions.push_back(expansion);
+            }
+            rewriting.cost = estimateCost(rewriting);
+            rewritings.push_back(rewriting);
+        }
+        return rewritings;
+    }
+    
+    // Rewrite many queries against the catalog in one pass. Queries are
+    // grouped by the set of relations they touch so each group computes its
+    // candidate views once and matches each distinct subgoal against the
+    // view atoms once, up front (see SeedTable). Results are parallel to
+    // `queries`; a query setQuery() rejects gets no rewritings. Leaves
+    // `query` set to the last query accepted.
+    vector<vector<QueryRewriting>> rewriteBatch(const vector<ConjunctiveQuery>& queries) {
+        vector<pair<vector<int>, size_t>> order;
+        for (size_t i = 0; i < queries.size(); ++i) {
+            vector<int> relations;
+            for (const auto& atom : queries[i].body) relations.push_back(atom.relation);
+            sort(relations.begin(), relations.end());
+            relations.erase(unique(relations.begin(), relations.end()), relations.end());
+            order.push_back({move(relations), i});
+        }
+        sort(order.begin(), order.end());
+        
+        vector<vector<QueryRewriting>> results(queries.size());
+        bool was_verbose = verbose;
+        verbose = false;
+        for (size_t begin = 0, end; begin < order.size(); begin = end) {
+            vector<const ConjunctiveQuery*> group;
+            for (end = begin; end < order.size() && order[end].first == order[begin].first; ++end) {
+                if (catalog->usesSymbols(queries[order[end].second])) {
+                    group.push_back(&queries[order[end].second]);
+                }
+            }
+            {
+                auto lock = catalog->readLock();
+                seed_table = make_shared<const SeedTable>(buildSeedTable(group));
+            }
+            for (const ConjunctiveQuery* q : group) {
+                if (setQuery(*q)) results[q - queries.data()] = rewrite();
+            }
+        }
+        seed_table = nullptr;
+        verbose = was_verbose;
+        return results;
+    }
+    
+    // Cache key of a complete rewrite of `canon`: the catalog version and
+    // the settings that change the rewritings returned
+    string cacheKey(const CanonicalQuery& canon) const {
+        string settings;
+        settings += prune_redundant ? 'p' : '-';
+        settings += minimize_query ? 'm' : '-';
+        settings += cover_engine == CoverEngine::DancingLinks ? 'x' : 'b';
+        return to_string(catalog->version) + "#" + settings + "#" + canon.fingerprint;
+    }
+    
+    // Express a rewriting of `query` in the canonical terms of `canon`
+    CachedRewriting toCanonical(const QueryRewriting& rw, 
+                                const CanonicalQuery& canon) const {
+        map<int, int> number;
+        for (size_t n = 0; n < canon.variables.size(); ++n) {
+            number[canon.variables[n]] = n;
+        }
+        CachedRewriting c;
+        c.view_indices = rw.view_indices;
+        c.view_atoms = rw.view_atoms;
+        c.cost = rw.cost;
+        c.aggregate_terms = rw.aggregate_terms;
+        c.regroup = rw.regroup;
+        for (const auto& m : rw.mappings) {
+            Mapping canonical;
+            for (const auto& [v_var, q_var] : m) {
+                canonical.entries.push_back({v_var, number.at(q_var)});
+            }
+            c.mappings.push_back(canonical);
+        }
+        for (size_t pos = 0; pos < canon.atom_order.size(); ++pos) {
+            if (rw.covered_subgoals.test(canon.atom_order[pos])) {
+                c.covered_subgoals.push_back(pos);
+            }
+        }
+        return c;
+    }
+    
+    // Replay a cached rewriting for the query whose canonical form is `canon`
+    QueryRewriting fromCanonical(const CachedRewriting& c, 
+                                 const CanonicalQuery& canon) const {
+        QueryRewriting rw;
+        rw.view_indices = c.view_indices;
+        rw.view_atoms = c.view_atoms;
+        rw.cost = c.cost;
+        rw.aggregate_terms = c.aggregate_terms;
+        rw.regroup = c.regroup;
+        for (const auto& m : c.mappings) {
+            Mapping mapping;
+            for (const auto& [v_var, n] : m) {
+                mapping.entries.push_back({v_var, canon.variables[n]});
+            }
+            rw.mappings.push_back(mapping);
+        }
+        rw.covered_subgoals = DynamicBitset(query.body.size());
+        for (int pos : c.covered_subgoals) rw.covered_subgoals.set(canon.atom_order[pos]);
+        return rw;
+    }
+    
+    // Find the single cheapest rewriting under the cost model; returns
+    // false if the query has no rewriting. With prune_redundant, repeated
+    // view occurrences are collapsed as in rewrite(), but containment
+    // pruning is not applied: it compares every pair of rewritings, which
+    // the branch-and-bound search never enumerates. The result can thus be
+    // a rewriting that rewrite() drops because another one contains it,
+    // one returning only part of that other rewriting's answer. Aggregate
+    // queries are the exception: their rewritings are all generated and
+    // filtered as in rewrite().
+    bool rewriteCheapest(QueryRewriting& best_rewriting) {
+        auto lock = catalog->readLock();
+        findMCDs();
+        
+        if (verbose) cout << "\n=== Step 2: Searching for the cheapest rewriting ===\n";
+        if (query.isAggregate()) {
+            vector<QueryRewriting> all;
+            aggregateRewritings(all);
+            if (all.empty()) return false;
+            rankRewritings(all);
+            best_rewriting = all.front();
+            return true;
+        }
+        auto index = buildCoverIndex();
+        if (!index->coverable) return false;
+        
+        vector<int> chosen, best;
+        double best_cost = 0;
+        DynamicBitset covered(query.body.size());
+        searchCheapest(*index, chosen, covered, allowedAfter(*index, chosen), JoinEstimate(),
+                       best, best_cost);
+        if (best.empty()) return false;
+        
+        best_rewriting = QueryRewriting();
+        for (int m : best) {
+            best_rewriting.view_indices.push_back(mcds[m].view_index);
+            best_rewriting.mappings.push_back(mcds[m].variable_mapping);
+        }
+        setViewAtoms(best_rewriting, best);
+        best_rewriting.covered_subgoals = DynamicBitset(query.body.size());
+        for (int m : best) best_rewriting.covered_subgoals |= mcds[m].covered_subgoals;
+        best_rewriting.cost = best_cost;
+        if (prune_redundant) {
+            size_t n_occurrences = best_rewriting.view_indices.size();
+            collapseDuplicateOccurrences(best_rewriting);
+            if (best_rewriting.view_indices.size() < n_occurrences) {
+                best_rewriting.cost = estimateCost(best_rewriting);
+            }
+        }
+        return true;
+    }
+    
+    void printQuery() const {
+        cout << "Query: " << query.toString() << "\n";
+    }
+    
+    void printViews() const {
+        cout << "Views:\n";
+        for (size_t i = 0; i < catalog->views.size(); ++i) {
+            if (!catalog->isLive(i)) continue;
+            cout << "  V" << i << ": " << catalog->views[i].toString() << "\n";
+        }
+    }
+};
+
+// ============================================================================
+// COLUMNAR EXECUTION
+// ============================================================================
+
+enum class ColumnType { Int64, Double, String };
+
+// One column of a table. The column does not manage its values itself:
+// `data` points at `length` fixed-width values (Int64, Double) or at
+// `length + 1` offsets into `chars` (String), and `owner` keeps that memory
+// alive, whether it is a vector built in memory or a mapped file.
+// `validity` holds a byte per row (zero = NULL), or is null when no value
+// is NULL. A dictionary-encoded string column has `codes`, the dictionary
+// entry of each row; `data` and `chars` then hold the dictionary.
+struct Column {
+    ColumnType type = ColumnType::Int64;
+    size_t length = 0;
+    const void* data = nullptr;
+    const char* chars = nullptr;
+    const uint8_t* validity = nullptr;
+    const uint32_t* codes = nullptr;
+    shared_ptr<const void> owner;
+
+    bool isNull(size_t row) const { return validity && !validity[row]; }
+    bool numeric() const { return type != ColumnType::String; }
+
+    int64_t intAt(size_t row) const { return static_cast<const int64_t*>(data)[row]; }
+    double doubleAt(size_t row) const { return static_cast<const double*>(data)[row]; }
+
+    // Either numeric type as a double
+    double numberAt(size_t row) const {
+        return type == ColumnType::Int64 ? (double)intAt(row) : doubleAt(row);
+    }
+
+    string_view stringAt(size_t row) const {
+        const uint64_t* offsets = static_cast<const uint64_t*>(data);
+        if (codes) row = codes[row];
+        return string_view(chars + offsets[row], offsets[row + 1] - offsets[row]);
+    }
+
+    string toString(size_t row) const {
+        if (isNull(row)) return "NULL";
+        switch (type) {
+            case ColumnType::Int64: return to_string(intAt(row));
+            case ColumnType::Double: {
+                stringstream ss;
+                ss << setprecision(15) << doubleAt(row);
+                return ss.str();
+            }
+            case ColumnType::String: return string(stringAt(row));
+        }
+        return "?";
+    }
+};
+
+// Appends values to a column held in vectors; finish() hands the vectors
+// over as the column's owner
+class ColumnBuilder {
+public:
+    explicit ColumnBuilder(ColumnType t) : type(t), storage(make_shared<Storage>()) {}
+
+    void appendInt(int64_t value) {
+        storage->ints.push_back(value);
+        storage->validity.push_back(1);
+    }
+
+    void appendDouble(double value) {
+        storage->doubles.push_back(value);
+        storage->validity.push_back(1);
+    }
+
+    void appendString(string_view value) {
+        storage->chars.append(value.data(), value.size());
+        storage->offsets.push_back(storage->chars.size());
+        storage->validity.push_back(1);
+    }
+
+    // A numeric value in whatever representation the column uses
+    void appendNumber(double value) {
+        if (type == ColumnType::Int64) appendInt((int64_t)value); else appendDouble(value);
+    }
+
+    void appendNull() {
+        switch (type) {
+            case ColumnType::Int64: storage->ints.push_back(0); break;
+            case ColumnType::Double: storage->doubles.push_back(0); break;
+            case ColumnType::String: storage->offsets.push_back(storage->chars.size()); break;
+        }
+        storage->validity.push_back(0);
+        has_null = true;
+    }
+
+    // Copy row `row` of a column of the same type
+    void appendFrom(const Column& column, size_t row) {
+        if (column.isNull(row)) {
+            appendNull();
+            return;
+        }
+        switch (type) {
+            case ColumnType::Int64: appendInt(column.intAt(row)); break;
+            case ColumnType::Double: appendDouble(column.numberAt(row)); break;
+            case ColumnType::String: appendString(column.stringAt(row)); break;
+        }
+    }
+
+    // Parse a text field for this column's type; an empty field is NULL.
+    // Returns false (appending NULL) if a numeric field does not parse.
+    bool appendText(string_view text) {
+        if (text.empty()) {
+            appendNull();
+            return true;
+        }
+        if (type == ColumnType::String) {
+            appendString(text);
+            return true;
+        }
+        const char* end = text.data() + text.size();
+        if (type == ColumnType::Int64) {
+            int64_t value;
+            auto [ptr, ec] = from_chars(text.data(), end, value);
+            if (ec == errc() && ptr == end) {
+                appendInt(value);
+                return true;
+            }
+        } else {
+            double value;
+            auto [ptr, ec] = from_chars(text.data(), end, value);
+            if (ec == errc() && ptr == end) {
+                appendDouble(value);
+                return true;
+            }
+        }
+        appendNull();
+        return false;
+    }
+
+    // Append every row of a column of the same type
+    void appendColumn(const Column& column) {
+        size_t n = column.length;
+        switch (type) {
+            case ColumnType::Int64: {
+                const int64_t* values = static_cast<const int64_t*>(column.data);
+                storage->ints.insert(storage->ints.end(), values, values + n);
+                break;
+            }
+            case ColumnType::Double: {
+                const double* values = static_cast<const double*>(column.data);
+                storage->doubles.insert(storage->doubles.end(), values, values + n);
+                break;
+            }
+            case ColumnType::String: {
+                if (column.codes) {
+                    for (size_t i = 0; i < n; ++i) {
+                        if (column.isNull(i)) appendNull(); else appendString(column.stringAt(i));
+                    }
+                    return;
+                }
+                const uint64_t* offsets = static_cast<const uint64_t*>(column.data);
+                uint64_t shift = storage->chars.size() - offsets[0];
+                storage->chars.append(column.chars + offsets[0], offsets[n] - offsets[0]);
+                for (size_t i = 1; i <= n; ++i) storage->offsets.push_back(offsets[i] + shift);
+                break;
+            }
+        }
+        if (column.validity) {
+            storage->validity.insert(storage->validity.end(), column.validity, column.validity + n);
+            has_null = true;
+        } else {
+            storage->validity.insert(storage->validity.end(), n, 1);
+        }
+    }
+
+    void reserve(size_t n) {
+        switch (type) {
+            case ColumnType::Int64: storage->ints.reserve(n); break;
+            case ColumnType::Double: storage->doubles.reserve(n); break;
+            case ColumnType::String: storage->offsets.reserve(n + 1); break;
+        }
+        storage->validity.reserve(n);
+    }
+
+    Column finish() {
+        Column column;
+        column.type = type;
+        column.length = storage->validity.size();
+        switch (type) {
+            case ColumnType::Int64: column.data = storage->ints.data(); break;
+            case ColumnType::Double: column.data = storage->doubles.data(); break;
+            case ColumnType::String:
+                column.data = storage->offsets.data();
+                column.chars = storage->chars.data();
+                break;
+        }
+        if (has_null) column.validity = storage->validity.data();
+        column.owner = storage;
+        storage = make_shared<Storage>();
+        has_null = false;
+        return column;
+    }
+
+private:
+    struct Storage {
+        vector<int64_t> ints;
+        vector<double> doubles;
+        vector<uint64_t> offsets{0};
+        string chars;
+        vector<uint8_t> validity;
+    };
+
+    ColumnType type;
+    shared_ptr<Storage> storage;
+    bool has_null = false;
+};
+
+struct Table {
+    vector<string> names;
+    vector<Column> columns;
+    size_t n_rows = 0;      // Kept apart from the columns: a table may have none
+
+    size_t rows() const { return n_rows; }
+
+    void addColumn(const string& name, Column column) {
+        n_rows = column.length;
+        names.push_back(name);
+        columns.push_back(move(column));
+    }
+
+    int columnIndex(const string& name) const {
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (names[i] == name) return i;
+        }
+        return -1;
+    }
+
+    string toString(size_t max_rows = 10) const {
+        stringstream ss;
+        for (size_t c = 0; c < names.size(); ++c) ss << (c ? " | " : "") << names[c];
+        ss << "\n";
+        for (size_t r = 0; r < min(n_rows, max_rows); ++r) {
+            for (size_t c = 0; c < columns.size(); ++c) {
+                ss << (c ? " | " : "") << columns[c].toString(r);
+            }
+            ss << "\n";
+        }
+        if (n_rows > max_rows) ss << "... (" << n_rows << " rows)\n";
+        return ss.str();
+    }
+};
+
+// Equi-join kernel over column batches. The build side goes into a
+// bucket-chained table laid out as arrays (bucket heads, a next entry per
+// build row, the row hashes); the probe side runs BATCH rows at a time:
+// hash the batch column by column, fetch every row's chain head, then
+// verify and advance all live chains together until none remain. When all
+// keys are Int64 on both sides, each key column of a batch is gathered into
+// a contiguous buffer and hashed by multiply-shift over the raw values,
+// four at a time with AVX2 where the CPU has it (checked at run time, so
+// no compiler flag is needed); mixed keys hash by numeric value so that
+// Int64 and Double columns can still join. NULL keys never match.
+class HashJoin {
+public:
+    static constexpr size_t BATCH = 1024;
+
+    // One key column read through a row-id vector: entry i of the side is
+    // row rows[i] of `column`
+    struct Key {
+        const Column* column;
+        const uint32_t* rows;
+    };
+
+    // Matching (probe entry, build entry) pairs
+    struct Matches {
+        vector<uint32_t> probe;
+        vector<uint32_t> build;
+    };
+
+    static uint64_t hashValue(const Column& column, size_t row) {
+        if (column.type == ColumnType::String) return hash<string_view>()(column.stringAt(row));
+        double value = column.numberAt(row);
+        if (value == 0) value = 0;  // -0.0 and 0.0 hash alike
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof bits);
+        return mix(bits);
+    }
+
+    static bool valuesEqual(const Column& a, size_t i, const Column& b, size_t j) {
+        if (a.isNull(i) || b.isNull(j)) return false;
+        if (a.numeric() != b.numeric()) return false;
+        if (!a.numeric()) return a.stringAt(i) == b.stringAt(j);
+        return a.numberAt(i) == b.numberAt(j);
+    }
+
+    // Join `build_size` entries of `build_keys` with `probe_size` entries
+    // of `probe_keys`, key k of one side against key k of the other. With
+    // no keys every pair matches.
+    static Matches join(const vector<Key>& build_keys, size_t build_size,
+                        const vector<Key>& probe_keys, size_t probe_size) {
+        bool integral = true;
+        for (size_t k = 0; k < build_keys.size(); ++k) {
+            integral &= build_keys[k].column->type == ColumnType::Int64 &&
+                        probe_keys[k].column->type == ColumnType::Int64;
+        }
+
+        // Build
+        size_t n_buckets = 16;
+        while (n_buckets < 2 * build_size) n_buckets *= 2;
+        uint64_t mask = n_buckets - 1;
+        vector<uint32_t> heads(n_buckets, EMPTY);
+        vector<uint32_t> next(build_size, EMPTY);
+        vector<uint64_t> build_hashes(build_size);
+        vector<uint8_t> valid(BATCH);
+        for (size_t begin = 0; begin < build_size; begin += BATCH) {
+            size_t n = min(BATCH, build_size - begin);
+            uint64_t* hashes = build_hashes.data() + begin;
+            hashBatch(build_keys, integral, begin, n, hashes, valid.data());
+            // Insert in reverse so that chains list build entries in order
+            for (size_t i = n; i-- > 0;) {
+                if (!valid[i]) continue;
+                uint32_t& head = heads[hashes[i] & mask];
+                next[begin + i] = head;
+                head = begin + i;
+            }
+        }
+
+        // Probe
+        Matches matches;
+        vector<uint64_t> hashes(BATCH);
+        vector<uint32_t> chain(BATCH);
+        vector<uint32_t> live(BATCH);
+        vector<uint8_t> equal(BATCH);
+        for (size_t begin = 0; begin < probe_size; begin += BATCH) {
+            size_t n = min(BATCH, probe_size - begin);
+            hashBatch(probe_keys, integral, begin, n, hashes.data(), valid.data());
+            size_t n_live = 0;
+            for (size_t i = 0; i < n; ++i) {
+                chain[i] = valid[i] ? heads[hashes[i] & mask] : EMPTY;
+                if (chain[i] != EMPTY) live[n_live++] = i;
+            }
+            while (n_live > 0) {
+                for (size_t l = 0; l < n_live; ++l) {
+                    size_t i = live[l];
+                    equal[l] = build_hashes[chain[i]] == hashes[i];
+                }
+                for (size_t k = 0; k < build_keys.size(); ++k) {
+                    verifyBatch(build_keys[k], probe_keys[k], integral, begin, chain.data(),
+                                live.data(), n_live, equal.data());
+                }
+                size_t still_live = 0;
+                for (size_t l = 0; l < n_live; ++l) {
+                    size_t i = live[l];
+                    if (equal[l]) {
+                        matches.probe.push_back(begin + i);
+                        matches.build.push_back(chain[i]);
+                    }
+                    chain[i] = next[chain[i]];
+                    if (chain[i] != EMPTY) live[still_live++] = i;
+                }
+                n_live = still_live;
+            }
+        }
+        return matches;
+    }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static constexpr uint64_t MIX_FACTOR = 0x9E3779B97F4A7C15ULL;
+
+    static uint64_t mix(uint64_t x) {
+        x *= MIX_FACTOR;
+        return x ^ (x >> 29);
+    }
+
+    // hashes[i] = hashes[i] * 31 + mix(values[i]) for i < n
+    static void mixInto(const uint64_t* values, uint64_t* hashes, size_t n) {
+#if defined(__x86_64__)
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2) {
+            mixIntoAVX2(values, hashes, n);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < n; ++i) hashes[i] = hashes[i] * 31 + mix(values[i]);
+    }
+
+#if defined(__x86_64__)
+    // mixInto four lanes at a time. AVX2 has no 64-bit multiply, so x * k
+    // is lo(x) * lo(k) plus the two cross products shifted up 32 bits.
+    __attribute__((target("avx2")))
+    static void mixIntoAVX2(const uint64_t* values, uint64_t* hashes, size_t n) {
+        const __m256i factor_lo = _mm256_set1_epi64x(MIX_FACTOR & 0xFFFFFFFF);
+        const __m256i factor_hi = _mm256_set1_epi64x(MIX_FACTOR >> 32);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), factor_lo),
+                                             _mm256_mul_epu32(x, factor_hi));
+            __m256i product = _mm256_add_epi64(_mm256_mul_epu32(x, factor_lo),
+                                               _mm256_slli_epi64(cross, 32));
+            __m256i mixed = _mm256_xor_si256(product, _mm256_srli_epi64(product, 29));
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i));
+            h = _mm256_sub_epi64(_mm256_slli_epi64(h, 5), h);     // h * 31
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + i), _mm256_add_epi64(h, mixed));
+        }
+        for (; i < n; ++i) hashes[i] = hashes[i] * 31 + mix(values[i]);
+    }
+#endif
+
+    // Hash entries [begin, begin + n) of a side, one key column at a
+    // time; valid[i] is cleared where any key is NULL
+    static void hashBatch(const vector<Key>& keys, bool integral, size_t begin, size_t n,
+                          uint64_t* hashes, uint8_t* valid) {
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = 0;
+            valid[i] = 1;
+        }
+        uint64_t gathered[BATCH];
+        for (const Key& key : keys) {
+            const Column& c = *key.column;
+            const uint32_t* rows = key.rows + begin;
+            if (integral) {
+                const int64_t* values = static_cast<const int64_t*>(c.data);
+                for (size_t i = 0; i < n; ++i) gathered[i] = values[rows[i]];
+                mixInto(gathered, hashes, n);
+            } else {
+                for (size_t i = 0; i < n; ++i) {
+                    hashes[i] = hashes[i] * 31 + hashValue(c, rows[i]);
+                }
+            }
+            if (c.validity) {
+                for (size_t i = 0; i < n; ++i) valid[i] &= c.validity[rows[i]];
+            }
+        }
+    }
+
+    // For the live probe entries, AND into equal[] whether their key
+    // equals that of the build entry their chain is at
+    static void verifyBatch(const Key& build, const Key& probe, bool integral, size_t begin,
+                            const uint32_t* chain, const uint32_t* live, size_t n_live,
+                            uint8_t* equal) {
+        if (integral) {
+            const int64_t* build_values = static_cast<const int64_t*>(build.column->data);
+            const int64_t* probe_values = static_cast<const int64_t*>(probe.column->data);
+            for (size_t l = 0; l < n_live; ++l) {
+                size_t i = live[l];
+                equal[l] &= build_values[build.rows[chain[i]]] == probe_values[probe.rows[begin + i]];
+            }
+            return;
+        }
+        for (size_t l = 0; l < n_live; ++l) {
+            if (!equal[l]) continue;
+            size_t i = live[l];
+            equal[l] = valuesEqual(*build.column, build.rows[chain[i]],
+                                   *probe.column, probe.rows[begin + i]);
+        }
+    }
+};
+
+// Evaluates conjunctive queries and rewritings over columnar tables, with
+// SQL bag semantics. A query atom reads the table named after its
+// relation, its columns matching the atom's terms by position; a view
+// occurrence in a rewriting reads the table named after the view, whose
+// columns are the view's head followed by its aggregates. Outer-join
+// views evaluate as the converter models them, padding the preserved
+// side's unmatched rows with NULLs. Tables are registered up front and
+// must not change while queries run. applyDelta changes a table in place
+// only while the executor holds the sole reference to it, so a table
+// obtained from table() never changes under its holder.
+class ColumnarExecutor {
+public:
+    void addTable(const string& name, shared_ptr<const Table> table) {
+        string key = Utils::toLower(name);
+        tables[key] = move(table);
+        forget(key);
+    }
+
+    bool dropTable(const string& name) {
+        string key = Utils::toLower(name);
+        forget(key);
+        return tables.erase(key) > 0;
+    }
+
+    shared_ptr<const Table> table(const string& name) const {
+        auto it = tables.find(Utils::toLower(name));
+        return it != tables.end() ? it->second : nullptr;
+    }
+
+    // Evaluate `q` over the tables named by its relations; atom i reads
+    // overrides[i] instead when given. Returns the head columns followed
+    // by the aggregates, if any.
+    Table execute(const ConjunctiveQuery& q,
+                  const map<size_t, shared_ptr<const Table>>& overrides = {}) const {
+        Plan plan;
+        if (!queryPlan(q, overrides, plan)) return Table();
+        return run(plan);
+    }
+
+    // Evaluate a rewriting of `query` over the materialized views. Joins
+    // follow the shared query variables of the occurrences; the query's
+    // range predicates, the outer-join NULL tests and any aggregation are
+    // applied as toSQL describes them.
+    Table execute(const QueryRewriting& rw, const vector<ConjunctiveQuery>& views,
+                  const ConjunctiveQuery& query) const {
+        Plan plan;
+        // Columns a rewriting does not join on get variables of their own,
+        // numbered past the symbol table
+        int next_fresh = query.symbols->size();
+        map<pair<size_t, int>, int> column_vars;   // (occurrence, view variable) -> plan variable
+        for (size_t i = 0; i < rw.view_indices.size(); ++i) {
+            const ConjunctiveQuery& view = views[rw.view_indices[i]];
+            shared_ptr<const Table> source = table(view.name);
+            if (!source || source->columns.size() != view.head.size() + view.aggregates.size()) {
+                cerr << "ColumnarExecutor: view " << view.name << " is not materialized\n";
+                return Table();
+            }
+            PlanAtom scan;
+            scan.table = source.get();
+            for (const auto& t : view.head) {
+                int image = rw.mappings[i].find(t.id);
+                if (image == -1) image = next_fresh++;
+                scan.vars.push_back(image);
+                column_vars[{i, t.id}] = image;
+            }
+            for (const auto& agg : view.aggregates) {
+                scan.vars.push_back(next_fresh);
+                column_vars[{i, agg.output}] = next_fresh++;
+            }
+            for (size_t a = 0; a < view.body.size(); ++a) {
+                if (!view.body[a].nullable || !rw.usesAtom(i, a)) continue;
+                int test = view.nullTestVariable(a);
+                for (size_t pos = 0; pos < view.head.size(); ++pos) {
+                    if (view.head[pos].id == test) scan.not_null.push_back(pos);
+                }
+            }
+            plan.atoms.push_back(move(scan));
+            plan.sources.push_back(source);
+        }
+        plan.ranges = query.intervals();
+        for (const auto& t : query.head) plan.output.push_back({t.id, query.symbols->name(t.id)});
+        for (size_t k = 0; k < rw.aggregate_terms.size(); ++k) {
+            const AggregateTerm& term = rw.aggregate_terms[k];
+            int var = term.var == -1 ? -1 : column_vars.at({term.occurrence, term.var});
+            int weight = term.weight == -1 ? -1 : column_vars.at({term.occurrence, term.weight});
+            plan.aggregates.push_back({term.op, var, weight,
+                                       query.symbols->name(query.aggregates[k].output)});
+        }
+        if (!rw.aggregate_terms.empty()) plan.group_by = query.group_by;
+        plan.regroup = rw.regroup;
+        return run(plan);
+    }
+
+    // Compute a view from the base tables and register it under its name
+    shared_ptr<const Table> materialize(const ConjunctiveQuery& view) {
+        auto result = make_shared<const Table>(execute(view));
+        addTable(view.name, result);
+        return result;
+    }
+
+    // Change base table `relation`: remove the rows of `deleted` (one
+    // occurrence each, ignoring rows it does not hold), append those of
+    // `inserted`, and bring the materialized views among `views` up to
+    // date. The table and its select-project-join views change in place:
+    // rows to delete are found through a hash index on all columns, and
+    // a view's change is computed from the changed rows alone, joined to
+    // the view's other atoms through hash indexes on their join columns
+    // (see viewChange). The work follows the size of the change, except
+    // that building an index scans its table once, and a table is copied
+    // the first time it changes or while a table() caller still holds it.
+    // Aggregate and outer-join views are recomputed in full. Returns
+    // false, with nothing changed, if the rows do not fit the table.
+    bool applyDelta(const string& relation, const Table& inserted, const Table& deleted,
+                    const vector<ConjunctiveQuery>& views) {
+        string name = Utils::toLower(relation);
+        {
+            shared_ptr<const Table> old_rows = table(name);
+            if (!old_rows) {
+                cerr << "ColumnarExecutor: no table " << relation << "\n";
+                return false;
+            }
+            for (const Table* rows : {&inserted, &deleted}) {
+                if (!sameColumns(*old_rows, *rows)) {
+                    cerr << "ColumnarExecutor: change rows do not match the columns of " << relation << "\n";
+                    return false;
+                }
+            }
+        }
+
+        vector<const ConjunctiveQuery*> incremental, recompute;
+        vector<vector<size_t>> changed_atoms;
+        for (const auto& view : views) {
+            vector<size_t> atoms;
+            for (size_t i = 0; i < view.body.size(); ++i) {
+                if (Utils::toLower(view.symbols->name(view.body[i].relation)) == name) atoms.push_back(i);
+            }
+            if (atoms.empty() || !table(view.name)) continue;
+            if (view.isAggregate() || view.hasOuterJoin()) {
+                recompute.push_back(&view);
+                continue;
+            }
+            incremental.push_back(&view);
+            changed_atoms.push_back(move(atoms));
+        }
+        own(name);
+        for (const ConjunctiveQuery* view : incremental) own(Utils::toLower(view->name));
+
+        // Deletions, evaluated before the rows go: atoms over the relation
+        // before the one reading the deleted rows see the table without
+        // them, the atoms after it the table as it was
+        vector<uint32_t> removed = matchRows(name, deleted);
+        sort(removed.begin(), removed.end());
+        RowSource all, gone, kept;
+        gone.rows = &removed;
+        kept.skip = &removed;
+        vector<vector<Table>> view_deleted;
+        for (size_t v = 0; v < incremental.size(); ++v) {
+            view_deleted.push_back(viewChange(*incremental[v], changed_atoms[v], kept, gone, all));
+        }
+        removeRows(name, removed);
+
+        // Insertions, evaluated after the rows arrive: atoms before the one
+        // reading the new rows see the whole table, the atoms after it the
+        // table without them
+        uint32_t n_kept = owned.at(name).table->rows();
+        appendRows(name, inserted);
+        vector<uint32_t> added;
+        for (size_t r = 0; r < inserted.rows(); ++r) added.push_back(n_kept + r);
+        RowSource fresh, older;
+        fresh.rows = &added;
+        older.limit = n_kept;
+        for (size_t v = 0; v < incremental.size(); ++v) {
+            vector<Table> view_inserted = viewChange(*incremental[v], changed_atoms[v], all, fresh, older);
+            string view_name = Utils::toLower(incremental[v]->name);
+            for (const Table& rows : view_deleted[v]) removeRows(view_name, matchRows(view_name, rows));
+            for (const Table& rows : view_inserted) appendRows(view_name, rows);
+        }
+
+        for (const ConjunctiveQuery* view : recompute) materialize(*view);
+        return true;
+    }
+
+private:
+    // Same number of columns of the same types; a table without columns
+    // stands for no rows and fits any other
+    static bool sameColumns(const Table& table, const Table& rows) {
+        if (rows.columns.empty()) return true;
+        if (rows.columns.size() != table.columns.size()) return false;
+        for (size_t c = 0; c < rows.columns.size(); ++c) {
+            if (rows.columns[c].type != table.columns[c].type) return false;
+        }
+        return true;
+    }
+
+    // Rows compare equal when every column does, NULL matching NULL
+    static bool rowsEqual(const Table& a, size_t i, const Table& b, size_t j) {
+        for (size_t c = 0; c < a.columns.size(); ++c) {
+            bool a_null = a.columns[c].isNull(i), b_null = b.columns[c].isNull(j);
+            if (a_null != b_null) return false;
+            if (!a_null && !HashJoin::valuesEqual(a.columns[c], i, b.columns[c], j)) return false;
+        }
+        return true;
+    }
+
+    // Hash of some columns of a row, a NULL hashing as 0
+    static uint64_t keyHash(const Table& t, size_t row, const vector<size_t>& columns) {
+        uint64_t h = 0;
+        for (size_t c : columns) {
+            h = h * 31 + (t.columns[c].isNull(row) ? 0 : HashJoin::hashValue(t.columns[c], row));
+        }
+        return h;
+    }
+
+    // The values of one column of a table the executor changes in place.
+    // Strings are dictionary-encoded, so that a row moves by its code
+    // alone; the dictionary only grows.
+    struct ColumnStore {
+        ColumnType type;
+        vector<int64_t> ints;
+        vector<double> doubles;
+        vector<uint64_t> offsets{0, 0};             // Dictionary, entry 0 the empty string
+        string chars;
+        unordered_map<string, uint32_t> entries;
+        vector<uint32_t> codes;
+        vector<uint8_t> validity;
+        size_t n_nulls = 0;
+
+        explicit ColumnStore(ColumnType t) : type(t) { entries[""] = 0; }
+
+        void append(const Column& column, size_t row) {
+            bool null = column.isNull(row);
+            validity.push_back(!null);
+            n_nulls += null;
+            switch (type) {
+                case ColumnType::Int64: ints.push_back(null ? 0 : column.intAt(row)); break;
+                case ColumnType::Double: doubles.push_back(null ? 0 : column.numberAt(row)); break;
+                case ColumnType::String: {
+                    string_view value = null ? string_view() : column.stringAt(row);
+                    auto [it, added] = entries.emplace(string(value), offsets.size() - 1);
+                    if (added) {
+                        chars.append(value.data(), value.size());
+                        offsets.push_back(chars.size());
+                    }
+                    codes.push_back(it->second);
+                    break;
+                }
+            }
+        }
+
+        // Drop row `row`; the last row takes its place
+        void remove(size_t row) {
+            size_t last = validity.size() - 1;
+            n_nulls -= !validity[row];
+            validity[row] = validity[last];
+            validity.pop_back();
+            switch (type) {
+                case ColumnType::Int64: ints[row] = ints[last]; ints.pop_back(); break;
+                case ColumnType::Double: doubles[row] = doubles[last]; doubles.pop_back(); break;
+                case ColumnType::String: codes[row] = codes[last]; codes.pop_back(); break;
+            }
+        }
+
+        // Point `column` at the current values
+        void publish(Column& column) const {
+            column.type = type;
+            column.length = validity.size();
+            column.validity = n_nulls > 0 ? validity.data() : nullptr;
+            switch (type) {
+                case ColumnType::Int64: column.data = ints.data(); break;
+                case ColumnType::Double: column.data = doubles.data(); break;
+                case ColumnType::String:
+                    column.data = offsets.data();
+                    column.chars = chars.data();
+                    column.codes = codes.data();
+                    break;
+            }
+        }
+    };
+
+    // A registered table whose columns the executor owns
+    struct OwnedTable {
+        shared_ptr<Table> table;
+        vector<shared_ptr<ColumnStore>> stores;
+    };
+
+    // Rows of a table by the hash of some of their columns (see keyHash).
+    // Each bucket lists its rows in no particular order, and each row
+    // knows its place in its bucket, so a row leaves in constant time.
+    struct RowIndex {
+        unordered_map<uint64_t, vector<uint32_t>> buckets;
+        vector<uint64_t> hashes;        // Of each row
+        vector<uint32_t> places;        // Of each row within its bucket
+
+        const vector<uint32_t>* find(uint64_t h) const {
+            auto it = buckets.find(h);
+            return it == buckets.end() ? nullptr : &it->second;
+        }
+
+        void append(uint64_t h) {
+            vector<uint32_t>& bucket = buckets[h];
+            places.push_back(bucket.size());
+            bucket.push_back(hashes.size());
+            hashes.push_back(h);
+        }
+
+        // Drop row `row`; the last row takes its number
+        void remove(uint32_t row) {
+            auto it = buckets.find(hashes[row]);
+            vector<uint32_t>& bucket = it->second;
+            uint32_t moved = bucket.back();
+            bucket[places[row]] = moved;
+            places[moved] = places[row];
+            bucket.pop_back();
+            if (bucket.empty()) buckets.erase(it);
+            uint32_t last = hashes.size() - 1;
+            if (row != last) {
+                buckets[hashes[last]][places[last]] = row;
+                hashes[row] = hashes[last];
+                places[row] = places[last];
+            }
+            hashes.pop_back();
+            places.pop_back();
+        }
+    };
+
+    // Drop the owned columns and indexes of a table being replaced
+    void forget(const string& name) {
+        owned.erase(name);
+        indexes.erase(name);
+    }
+
+    // Make table `name` one the executor may change in place, copying it
+    // into owned columns unless it already is one nobody else holds
+    void own(const string& name) {
+        auto it = owned.find(name);
+        if (it != owned.end() && it->second.table.use_count() == 2) {
+            bool sole = true;
+            for (const auto& store : it->second.stores) sole &= store.use_count() == 2;
+            if (sole) return;
+        }
+        shared_ptr<const Table> current = tables.at(name);
+        OwnedTable copy;
+        copy.table = make_shared<Table>();
+        copy.table->names = current->names;
+        copy.table->n_rows = current->rows();
+        for (const Column& column : current->columns) {
+            auto store = make_shared<ColumnStore>(column.type);
+            for (size_t r = 0; r < current->rows(); ++r) store->append(column, r);
+            Column values;
+            store->publish(values);
+            values.owner = store;
+            copy.table->columns.push_back(values);
+            copy.stores.push_back(store);
+        }
+        tables[name] = copy.table;
+        indexes.erase(name);
+        owned[name] = move(copy);
+    }
+
+    // The index of table `name` on `columns`, built on first use. The
+    // indexes of owned tables follow their changes.
+    const RowIndex& rowIndex(const string& name, const Table& t, const vector<size_t>& columns) {
+        RowIndex& index = indexes[name][columns];
+        if (index.hashes.size() != t.rows()) {
+            index = RowIndex();
+            for (size_t r = 0; r < t.rows(); ++r) index.append(keyHash(t, r, columns));
+        }
+        return index;
+    }
+
+    // Rows of owned table `name` equal to those of `rows`, one occurrence
+    // each, leaving out rows it does not hold
+    vector<uint32_t> matchRows(const string& name, const Table& rows) {
+        const Table& t = *owned.at(name).table;
+        vector<size_t> all;
+        for (size_t c = 0; c < t.columns.size(); ++c) all.push_back(c);
+        const RowIndex& index = rowIndex(name, t, all);
+        vector<uint32_t> found;
+        set<uint32_t> taken;
+        for (size_t r = 0; r < rows.rows(); ++r) {
+            const vector<uint32_t>* candidates = index.find(keyHash(rows, r, all));
+            if (!candidates) continue;
+            for (uint32_t row : *candidates) {
+                if (!taken.count(row) && rowsEqual(t, row, rows, r)) {
+                    taken.insert(row);
+                    found.push_back(row);
+                    break;
+                }
+            }
+        }
+        return found;
+    }
+
+    // Remove rows of owned table `name`, each row's place going to the
+    // table's last row
+    void removeRows(const string& name, vector<uint32_t> rows) {
+        OwnedTable& t = owned.at(name);
+        sort(rows.rbegin(), rows.rend());
+        auto table_indexes = indexes.find(name);
+        for (uint32_t row : rows) {
+            if (table_indexes != indexes.end()) {
+                for (auto& [columns, index] : table_indexes->second) index.remove(row);
+            }
+            for (auto& store : t.stores) store->remove(row);
+            --t.table->n_rows;
+        }
+        for (size_t c = 0; c < t.stores.size(); ++c) t.stores[c]->publish(t.table->columns[c]);
+    }
+
+    void appendRows(const string& name, const Table& rows) {
+        OwnedTable& t = owned.at(name);
+        size_t first = t.table->rows();
+        for (size_t r = 0; r < rows.rows(); ++r) {
+            for (size_t c = 0; c < t.stores.size(); ++c) t.stores[c]->append(rows.columns[c], r);
+        }
+        t.table->n_rows += rows.rows();
+        for (size_t c = 0; c < t.stores.size(); ++c) t.stores[c]->publish(t.table->columns[c]);
+        auto table_indexes = indexes.find(name);
+        if (table_indexes == indexes.end()) return;
+        for (auto& [columns, index] : table_indexes->second) {
+            for (size_t r = first; r < t.table->rows(); ++r) index.append(keyHash(*t.table, r, columns));
+        }
+    }
+
+    // One scan: the table, the plan variable bound by each column (-1 for
+    // none), columns that must equal a constant or be non-NULL
+    struct PlanAtom {
+        const Table* table = nullptr;
+        vector<int> vars;
+        vector<pair<size_t, string>> constants;
+        vector<size_t> not_null;
+        bool nullable = false;      // Null-supplied side of an outer join
+    };
+
+    // op over plan variable `var` (rows for COUNT(*) when -1), times
+    // `weight` if set
+    struct PlanAggregate {
+        AggregateOp op;
+        int var;
+        int weight;
+        string name;
+    };
+
+    struct Plan {
+        vector<PlanAtom> atoms;
+        vector<shared_ptr<const Table>> sources;    // Keep the tables alive
+        map<int, Interval> ranges;                  // Including ON predicates
+        map<int, Interval> where_ranges;            // Without them (outer joins)
+        vector<pair<int, int>> equalities;          // ON equalities
+        vector<pair<int, string>> output;           // Variable, column name
+        vector<int> group_by;
+        vector<PlanAggregate> aggregates;
+        bool regroup = false;
+    };
+
+    // The plan evaluating `q` (see execute). False, with a message on cerr,
+    // if an atom has no table of its arity.
+    bool queryPlan(const ConjunctiveQuery& q, const map<size_t, shared_ptr<const Table>>& overrides,
+                   Plan& plan) const {
+        for (size_t i = 0; i < q.body.size(); ++i) {
+            const Atom& atom = q.body[i];
+            auto over = overrides.find(i);
+            shared_ptr<const Table> source = over != overrides.end() ? over->second
+                                                                     : table(q.symbols->name(atom.relation));
+            if (!source || source->columns.size() != atom.terms.size()) {
+                cerr << "ColumnarExecutor: no table of arity " << atom.terms.size()
+                     << " for " << q.symbols->name(atom.relation) << "\n";
+                return false;
+            }
+            PlanAtom scan;
+            scan.table = source.get();
+            scan.nullable = atom.nullable;
+            for (size_t pos = 0; pos < atom.terms.size(); ++pos) {
+                const Term& t = atom.terms[pos];
+                scan.vars.push_back(t.is_variable ? t.id : -1);
+                if (!t.is_variable) scan.constants.push_back({pos, q.symbols->name(t.id)});
+            }
+            plan.atoms.push_back(move(scan));
+            plan.sources.push_back(source);
+        }
+        plan.ranges = q.intervals(true);
+        plan.where_ranges = q.intervals();
+        plan.equalities = q.on_equalities;
+        for (const auto& t : q.head) plan.output.push_back({t.id, q.symbols->name(t.id)});
+        for (int var : q.group_by) plan.group_by.push_back(var);
+        for (const auto& agg : q.aggregates) {
+            plan.aggregates.push_back({agg.op, agg.arg, -1, q.symbols->name(agg.output)});
+        }
+        plan.regroup = q.isAggregate();
+        return true;
+    }
+
+    // Row of a padded atom in an outer-join result
+    static constexpr uint32_t NO_ROW = UINT32_MAX;
+
+    // Join result in late-materialized form: for each joined atom, the
+    // row it contributes to every result row
+    struct Bindings {
+        vector<int> atoms;                      // Plan atoms joined so far
+        vector<vector<uint32_t>> rows;          // Parallel to `atoms`
+        map<int, pair<int, size_t>> columns;    // Variable -> (slot in atoms, column)
+        size_t size = 0;
+
+        const Column& column(const Plan& plan, int var, size_t& slot) const {
+            auto [s, col] = columns.at(var);
+            slot = s;
+            return plan.atoms[atoms[s]].table->columns[col];
+        }
+    };
+
+    static bool missing(const Column& column, uint32_t row) {
+        return row == NO_ROW || column.isNull(row);
+    }
+
+    static bool inRange(const Interval& range, double value) {
+        Interval point;
+        point.lo = point.hi = value;
+        return range.contains(point);
+    }
+
+    // One atom's own filters: constants, NULL tests, a variable repeated
+    // within the atom, and ranges on its variables
+    struct AtomFilter {
+        const Table* table;
+        const vector<size_t>* not_null;
+        vector<pair<size_t, double>> numeric_constants;
+        vector<pair<size_t, string>> string_constants;
+        vector<pair<size_t, const Interval*>> ranges;
+        vector<pair<size_t, size_t>> repeats;
+
+        AtomFilter(const Plan& plan, const PlanAtom& atom) : table(atom.table), not_null(&atom.not_null) {
+            for (const auto& [pos, text] : atom.constants) {
+                double value;
+                if (table->columns[pos].numeric() && Utils::parseNumber(text, value)) {
+                    numeric_constants.push_back({pos, value});
+                } else {
+                    string unquoted = text.size() >= 2 && text.front() == '\'' && text.back() == '\''
+                                      ? text.substr(1, text.size() - 2) : text;
+                    string_constants.push_back({pos, unquoted});
+                }
+            }
+            for (size_t pos = 0; pos < atom.vars.size(); ++pos) {
+                if (atom.vars[pos] == -1) continue;
+                auto r = plan.ranges.find(atom.vars[pos]);
+                if (r != plan.ranges.end()) ranges.push_back({pos, &r->second});
+                for (size_t prev = 0; prev < pos; ++prev) {
+                    if (atom.vars[prev] == atom.vars[pos]) {
+                        repeats.push_back({prev, pos});
+                        break;
+                    }
+                }
+            }
+        }
+
+        bool passes(size_t row) const {
+            const Table& t = *table;
+            for (size_t pos : *not_null) {
+                if (t.columns[pos].isNull(row)) return false;
+            }
+            for (const auto& [pos, value] : numeric_constants) {
+                if (t.columns[pos].isNull(row) || t.columns[pos].numberAt(row) != value) return false;
+            }
+            for (const auto& [pos, value] : string_constants) {
+                if (t.columns[pos].isNull(row) || t.columns[pos].type != ColumnType::String ||
+                    t.columns[pos].stringAt(row) != value) return false;
+            }
+            for (const auto& [pos, range] : ranges) {
+                const Column& c = t.columns[pos];
+                if (c.isNull(row) || !c.numeric() || !inRange(*range, c.numberAt(row))) return false;
+            }
+            for (const auto& [a, b] : repeats) {
+                if (!HashJoin::valuesEqual(t.columns[a], row, t.columns[b], row)) return false;
+            }
+            return true;
+        }
+    };
+
+    // Rows of one atom passing its own filters
+    vector<uint32_t> scan(const Plan& plan, const PlanAtom& atom) const {
+        AtomFilter filter(plan, atom);
+        vector<uint32_t> selected;
+        selected.reserve(atom.table->rows());
+        for (size_t row = 0; row < atom.table->rows(); ++row) {
+            if (filter.passes(row)) selected.push_back(row);
+        }
+        return selected;
+    }
+
+    // Variables a column of variable `var` must equal: itself and its
+    // partners in ON equalities
+    static vector<int> equalVariables(const Plan& plan, int var) {
+        vector<int> vars{var};
+        for (const auto& [x, y] : plan.equalities) {
+            if (x == var) vars.push_back(y);
+            if (y == var) vars.push_back(x);
+        }
+        return vars;
+    }
+
+    // Hash join of `bindings` with the selected rows of plan atom
+    // `atom_idx` on the variables they share (a cross product if none),
+    // building on the smaller of the two
+    void join(const Plan& plan, Bindings& bindings, int atom_idx,
+              const vector<uint32_t>& selected) const {
+        const PlanAtom& atom = plan.atoms[atom_idx];
+        vector<HashJoin::Key> atom_keys, bound_keys;
+        for (size_t pos = 0; pos < atom.vars.size(); ++pos) {
+            if (atom.vars[pos] == -1) continue;
+            for (int var : equalVariables(plan, atom.vars[pos])) {
+                if (!bindings.columns.count(var)) continue;
+                size_t slot;
+                const Column& bound = bindings.column(plan, var, slot);
+                atom_keys.push_back({&atom.table->columns[pos], selected.data()});
+                bound_keys.push_back({&bound, bindings.rows[slot].data()});
+            }
+        }
+
+        HashJoin::Matches matches;
+        const vector<uint32_t>* bound_matches = &matches.probe;
+        const vector<uint32_t>* atom_matches = &matches.build;
+        if (selected.size() <= bindings.size) {
+            matches = HashJoin::join(atom_keys, selected.size(), bound_keys, bindings.size);
+        } else {
+            matches = HashJoin::join(bound_keys, bindings.size, atom_keys, selected.size());
+            swap(bound_matches, atom_matches);
+        }
+
+        vector<vector<uint32_t>> joined(bindings.rows.size() + 1);
+        for (size_t s = 0; s < bindings.rows.size(); ++s) {
+            const vector<uint32_t>& rows = bindings.rows[s];
+            joined[s].resize(bound_matches->size());
+            for (size_t m = 0; m < bound_matches->size(); ++m) joined[s][m] = rows[(*bound_matches)[m]];
+        }
+        joined.back().resize(atom_matches->size());
+        for (size_t m = 0; m < atom_matches->size(); ++m) joined.back()[m] = selected[(*atom_matches)[m]];
+        bindings.atoms.push_back(atom_idx);
+        bindings.rows = move(joined);
+        bindings.size = bindings.rows.back().size();
+    }
+
+    void bind(const Plan& plan, Bindings& bindings, int atom_idx) const {
+        const PlanAtom& atom = plan.atoms[atom_idx];
+        for (size_t pos = 0; pos < atom.vars.size(); ++pos) {
+            if (atom.vars[pos] != -1 && !bindings.columns.count(atom.vars[pos])) {
+                bindings.columns[atom.vars[pos]] = {bindings.atoms.size() - 1, pos};
+            }
+        }
+    }
+
+    // Join order: the smallest filtered atom first, then repeatedly the
+    // smallest atom sharing a variable with the result so far (any atom
+    // once none does)
+    Bindings joinAll(const Plan& plan) const {
+        vector<vector<uint32_t>> selected;
+        for (const auto& atom : plan.atoms) selected.push_back(scan(plan, atom));
+
+        Bindings bindings;
+        vector<bool> done(plan.atoms.size(), false);
+        for (size_t step = 0; step < plan.atoms.size(); ++step) {
+            int next = -1;
+            bool next_connected = false;
+            for (size_t a = 0; a < plan.atoms.size(); ++a) {
+                if (done[a]) continue;
+                bool connected = false;
+                for (int var : plan.atoms[a].vars) {
+                    if (var == -1) continue;
+                    for (int v : equalVariables(plan, var)) connected |= bindings.columns.count(v) > 0;
+                }
+                if (next == -1 || (connected && !next_connected) ||
+                    (connected == next_connected && selected[a].size() < selected[next].size())) {
+                    next = a;
+                    next_connected = connected;
+                }
+            }
+            done[next] = true;
+            if (step == 0) {
+                bindings.atoms.push_back(next);
+                bindings.rows.push_back(selected[next]);
+                bindings.size = selected[next].size();
+            } else {
+                join(plan, bindings, next, selected[next]);
+            }
+            bind(plan, bindings, next);
+        }
+        if (plan.atoms.empty()) bindings.size = 1;  // The empty join has one row
+        return bindings;
+    }
+
+    // The same rows with the atoms in plan order; a variable reads its
+    // column from a preserved atom where it has one
+    static Bindings inPlanOrder(const Plan& plan, const Bindings& joined) {
+        Bindings ordered;
+        ordered.size = joined.size;
+        ordered.rows.resize(plan.atoms.size());
+        for (size_t slot = 0; slot < joined.atoms.size(); ++slot) {
+            ordered.rows[joined.atoms[slot]] = joined.rows[slot];
+        }
+        for (size_t a = 0; a < plan.atoms.size(); ++a) ordered.atoms.push_back(a);
+        for (bool nullable : {false, true}) {
+            for (size_t a = 0; a < plan.atoms.size(); ++a) {
+                if (plan.atoms[a].nullable != nullable) continue;
+                for (size_t pos = 0; pos < plan.atoms[a].vars.size(); ++pos) {
+                    int var = plan.atoms[a].vars[pos];
+                    if (var != -1 && !ordered.columns.count(var)) ordered.columns[var] = {a, pos};
+                }
+            }
+        }
+        return ordered;
+    }
+
+    // Outer join as the converter models it: the rows where every atom
+    // matched under the ON predicates, then each row of the preserved atoms
+    // (the non-nullable ones, or each atom of a full join) that matched
+    // nothing, with NO_ROW for the other atoms
+    Bindings outerJoinAll(const Plan& plan) const {
+        Bindings result = inPlanOrder(plan, joinAll(plan));
+        vector<vector<int>> preserved_sides(1);
+        for (size_t a = 0; a < plan.atoms.size(); ++a) {
+            if (!plan.atoms[a].nullable) preserved_sides[0].push_back(a);
+        }
+        if (preserved_sides[0].empty()) {
+            preserved_sides.clear();
+            for (size_t a = 0; a < plan.atoms.size(); ++a) preserved_sides.push_back({(int)a});
+        }
+
+        for (const auto& side : preserved_sides) {
+            Plan preserved;
+            set<int> side_vars;
+            for (int a : side) {
+                preserved.atoms.push_back(plan.atoms[a]);
+                for (int var : plan.atoms[a].vars) side_vars.insert(var);
+            }
+            // A WHERE predicate on a padded column rejects the padded row
+            bool padded_rows_pass = true;
+            for (const auto& [var, range] : plan.where_ranges) padded_rows_pass &= side_vars.count(var) > 0;
+            if (!padded_rows_pass) continue;
+            preserved.ranges = plan.where_ranges;
+            Bindings rows = inPlanOrder(preserved, joinAll(preserved));
+
+            set<vector<uint32_t>> matched;
+            for (size_t r = 0; r < result.size; ++r) {
+                vector<uint32_t> key;
+                for (int a : side) key.push_back(result.rows[a][r]);
+                matched.insert(move(key));
             }
-            cout << "}\n    Distinguished vars: {";
-            first = true;
-            for (const auto& dv : mcds[i].distinguished_vars) {
-                if (!first) cout << ", ";
-                cout << dv;
-                first = false;
+            for (size_t r = 0; r < rows.size; ++r) {
+                vector<uint32_t> key;
+                for (size_t s = 0; s < side.size(); ++s) key.push_back(rows.rows[s][r]);
+                if (matched.count(key)) continue;
+                for (size_t a = 0; a < plan.atoms.size(); ++a) result.rows[a].push_back(NO_ROW);
+                for (size_t s = 0; s < side.size(); ++s) result.rows[side[s]].back() = key[s];
+                ++result.size;
             }
-            cout << "}\n";
         }
-        
-        cout << "\n=== Step 2: Combining MCDs to form rewritings ===\n";
-        // Generate rewritings
-        vector<QueryRewriting> rewritings;
-        generateRewritings(rewritings);
-        
-        return rewritings;
+        return result;
     }
-    
-    void printQuery() const {
-        cout << "Query: " << query.toString() << "\n";
+
+    Table project(const Plan& plan, const Bindings& bindings) const {
+        Table result;
+        for (const auto& [var, name] : plan.output) {
+            size_t slot;
+            const Column& source = bindings.column(plan, var, slot);
+            ColumnBuilder builder(source.type);
+            builder.reserve(bindings.size);
+            for (size_t r = 0; r < bindings.size; ++r) {
+                uint32_t row = bindings.rows[slot][r];
+                if (row == NO_ROW) builder.appendNull(); else builder.appendFrom(source, row);
+            }
+            result.addColumn(name, builder.finish());
+        }
+        result.n_rows = bindings.size;
+        return result;
     }
-    
-    void printViews() const {
-        cout << "Views:\n";
-        for (size_t i = 0; i < views.size(); ++i) {
-            cout << "  V" << i << ": " << views[i].toString() << "\n";
+
+    // Running value of one aggregate within one group
+    struct Accumulator {
+        int64_t count = 0;      // Rows (COUNT(*)) or non-NULL values seen
+        int64_t int_sum = 0;
+        double sum = 0;
+        double number = 0;      // MIN/MAX of a numeric column
+        string text;            // MIN/MAX of a string column
+    };
+
+    Table aggregate(const Plan& plan, const Bindings& bindings) const {
+        struct Input {
+            const Column* column = nullptr;
+            size_t slot = 0;
+            const Column* weight = nullptr;
+            size_t weight_slot = 0;
+        };
+        vector<Input> inputs;
+        for (const auto& agg : plan.aggregates) {
+            Input in;
+            if (agg.var != -1) in.column = &bindings.column(plan, agg.var, in.slot);
+            if (agg.weight != -1) in.weight = &bindings.column(plan, agg.weight, in.weight_slot);
+            inputs.push_back(in);
+        }
+        vector<pair<const Column*, size_t>> group_columns;
+        for (int var : plan.group_by) {
+            size_t slot;
+            const Column* c = &bindings.column(plan, var, slot);
+            group_columns.push_back({c, slot});
+        }
+
+        // Rows into groups: each group remembers its first result row
+        vector<size_t> group_first;
+        vector<size_t> group_of(bindings.size);
+        if (plan.regroup) {
+            unordered_multimap<uint64_t, size_t> index;
+            for (size_t r = 0; r < bindings.size; ++r) {
+                uint64_t h = 0;
+                for (const auto& [c, slot] : group_columns) {
+                    size_t row = bindings.rows[slot][r];
+                    h = h * 31 + (missing(*c, row) ? 0 : HashJoin::hashValue(*c, row));
+                }
+                int found = -1;
+                auto [first, last] = index.equal_range(h);
+                for (auto it = first; it != last && found == -1; ++it) {
+                    bool same = true;
+                    for (const auto& [c, slot] : group_columns) {
+                        size_t a = bindings.rows[slot][r];
+                        size_t b = bindings.rows[slot][group_first[it->second]];
+                        bool both_null = missing(*c, a) && missing(*c, b);
+                        same = same && (both_null || (!missing(*c, a) && !missing(*c, b) &&
+                                                      HashJoin::valuesEqual(*c, a, *c, b)));
+                    }
+                    if (same) found = it->second;
+                }
+                if (found == -1) {
+                    found = group_first.size();
+                    group_first.push_back(r);
+                    index.emplace(h, found);
+                }
+                group_of[r] = found;
+            }
+            // A global aggregate has its one group even over no rows
+            if (plan.group_by.empty() && group_first.empty()) group_first.push_back(SIZE_MAX);
+        } else {
+            for (size_t r = 0; r < bindings.size; ++r) {
+                group_of[r] = r;
+                group_first.push_back(r);
+            }
+        }
+
+        size_t n_groups = group_first.size();
+        vector<vector<Accumulator>> acc(plan.aggregates.size(), vector<Accumulator>(n_groups));
+        for (size_t k = 0; k < plan.aggregates.size(); ++k) {
+            const PlanAggregate& agg = plan.aggregates[k];
+            const Input& in = inputs[k];
+            for (size_t r = 0; r < bindings.size; ++r) {
+                Accumulator& a = acc[k][group_of[r]];
+                if (!in.column) {
+                    ++a.count;
+                    continue;
+                }
+                size_t row = bindings.rows[in.slot][r];
+                if (missing(*in.column, row)) continue;
+                if (in.weight && missing(*in.weight, bindings.rows[in.weight_slot][r])) continue;
+                bool first = a.count++ == 0;
+                if (agg.op == AggregateOp::Count) continue;
+                if (!in.column->numeric()) {
+                    string_view s = in.column->stringAt(row);
+                    if (first || (agg.op == AggregateOp::Min ? s < a.text : s > a.text)) a.text = s;
+                    continue;
+                }
+                double value = in.column->numberAt(row);
+                int64_t int_value = in.column->type == ColumnType::Int64 ? in.column->intAt(row) : 0;
+                if (in.weight) {
+                    size_t weight_row = bindings.rows[in.weight_slot][r];
+                    value *= in.weight->numberAt(weight_row);
+                    int_value *= in.weight->type == ColumnType::Int64 ? in.weight->intAt(weight_row) : 0;
+                }
+                if (agg.op == AggregateOp::Sum) {
+                    a.sum += value;
+                    a.int_sum += int_value;
+                } else if (first || (agg.op == AggregateOp::Min ? value < a.number : value > a.number)) {
+                    a.number = value;
+                }
+            }
+        }
+
+        Table result;
+        for (const auto& [var, name] : plan.output) {
+            size_t slot;
+            const Column& source = bindings.column(plan, var, slot);
+            ColumnBuilder builder(source.type);
+            for (size_t g = 0; g < n_groups; ++g) {
+                uint32_t row = group_first[g] == SIZE_MAX ? NO_ROW : bindings.rows[slot][group_first[g]];
+                if (row == NO_ROW) builder.appendNull(); else builder.appendFrom(source, row);
+            }
+            result.addColumn(name, builder.finish());
+        }
+        for (size_t k = 0; k < plan.aggregates.size(); ++k) {
+            const PlanAggregate& agg = plan.aggregates[k];
+            const Column* c = inputs[k].column;
+            bool integral = !c || (c->type == ColumnType::Int64 &&
+                                   (!inputs[k].weight || inputs[k].weight->type == ColumnType::Int64));
+            ColumnType type = agg.op == AggregateOp::Count ? ColumnType::Int64
+                            : agg.op == AggregateOp::Sum ? (integral ? ColumnType::Int64 : ColumnType::Double)
+                            : c->type;
+            ColumnBuilder builder(type);
+            for (size_t g = 0; g < n_groups; ++g) {
+                const Accumulator& a = acc[k][g];
+                if (agg.op == AggregateOp::Count) {
+                    builder.appendInt(a.count);
+                } else if (a.count == 0) {
+                    builder.appendNull();   // SUM, MIN and MAX of no values
+                } else if (type == ColumnType::String) {
+                    builder.appendString(a.text);
+                } else if (agg.op == AggregateOp::Sum) {
+                    if (type == ColumnType::Int64) builder.appendInt(a.int_sum);
+                    else builder.appendDouble(a.sum);
+                } else {
+                    builder.appendNumber(a.number);
+                }
+            }
+            result.addColumn(agg.name, builder.finish());
+        }
+        result.n_rows = n_groups;
+        return result;
+    }
+
+    // The rows of its table one atom reads while a change is applied: only
+    // `rows` if set, otherwise all but those in `skip` (sorted) and those
+    // from `limit` on
+    struct RowSource {
+        const vector<uint32_t>* rows = nullptr;
+        const vector<uint32_t>* skip = nullptr;
+        uint32_t limit = UINT32_MAX;
+
+        bool reads(uint32_t row) const {
+            return row < limit && !(skip && binary_search(skip->begin(), skip->end(), row));
+        }
+    };
+
+    // The rows `view` gains from a change to the relation of its atoms
+    // `atoms`, by the usual delta rule: for each of those atoms, the view
+    // with that atom reading `changed`, the atoms over the relation before
+    // it `earlier` and those after it `later`, so that a self-join counts
+    // each combination of changed rows once. One table per atom.
+    vector<Table> viewChange(const ConjunctiveQuery& view, const vector<size_t>& atoms,
+                             const RowSource& earlier, const RowSource& changed,
+                             const RowSource& later) {
+        vector<Table> parts;
+        Plan plan;
+        if (changed.rows->empty() || !queryPlan(view, {}, plan)) return parts;
+        for (size_t j = 0; j < atoms.size(); ++j) {
+            vector<RowSource> sources(plan.atoms.size());
+            for (size_t k = 0; k < atoms.size(); ++k) {
+                sources[atoms[k]] = k < j ? earlier : k == j ? changed : later;
+            }
+            parts.push_back(deltaRows(view, plan, atoms[j], sources));
+        }
+        return parts;
+    }
+
+    // `plan` (of `q`) evaluated with each atom reading the rows its source
+    // gives, starting from atom `driver`, whose source lists its rows. Each
+    // further atom is reached through a hash index on its columns bound so
+    // far, so the work follows the driver's rows rather than the tables;
+    // an atom sharing no variable with the rows so far is scanned and
+    // joined as in joinAll.
+    Table deltaRows(const ConjunctiveQuery& q, const Plan& plan, size_t driver,
+                    const vector<RowSource>& sources) {
+        Bindings bindings;
+        AtomFilter driver_filter(plan, plan.atoms[driver]);
+        vector<uint32_t> start;
+        for (uint32_t row : *sources[driver].rows) {
+            if (driver_filter.passes(row)) start.push_back(row);
+        }
+        bindings.atoms.push_back(driver);
+        bindings.rows.push_back(move(start));
+        bindings.size = bindings.rows[0].size();
+        bind(plan, bindings, driver);
+
+        vector<bool> done(plan.atoms.size(), false);
+        done[driver] = true;
+        for (size_t step = 1; step < plan.atoms.size(); ++step) {
+            // The first atom with a bound variable, else the first one left
+            size_t next = SIZE_MAX;
+            vector<size_t> keys;
+            for (size_t a = 0; a < plan.atoms.size() && keys.empty(); ++a) {
+                if (done[a]) continue;
+                if (next == SIZE_MAX) next = a;
+                for (size_t pos = 0; pos < plan.atoms[a].vars.size(); ++pos) {
+                    int var = plan.atoms[a].vars[pos];
+                    if (var != -1 && bindings.columns.count(var)) keys.push_back(pos);
+                }
+                if (!keys.empty()) next = a;
+            }
+            done[next] = true;
+            const PlanAtom& atom = plan.atoms[next];
+            const RowSource& source = sources[next];
+            AtomFilter filter(plan, atom);
+            if (keys.empty()) {
+                vector<uint32_t> selected;
+                for (uint32_t row = 0; row < atom.table->rows(); ++row) {
+                    if (source.reads(row) && filter.passes(row)) selected.push_back(row);
+                }
+                join(plan, bindings, next, selected);
+                bind(plan, bindings, next);
+                continue;
+            }
+
+            const RowIndex& index = rowIndex(Utils::toLower(q.symbols->name(q.body[next].relation)),
+                                             *atom.table, keys);
+            vector<const Column*> bound;
+            vector<size_t> slots;
+            for (size_t pos : keys) {
+                size_t slot;
+                bound.push_back(&bindings.column(plan, atom.vars[pos], slot));
+                slots.push_back(slot);
+            }
+            vector<vector<uint32_t>> joined(bindings.rows.size() + 1);
+            for (size_t r = 0; r < bindings.size; ++r) {
+                uint64_t h = 0;
+                bool null_key = false;
+                for (size_t k = 0; k < keys.size() && !null_key; ++k) {
+                    uint32_t row = bindings.rows[slots[k]][r];
+                    null_key = bound[k]->isNull(row);
+                    if (!null_key) h = h * 31 + HashJoin::hashValue(*bound[k], row);
+                }
+                const vector<uint32_t>* candidates = null_key ? nullptr : index.find(h);
+                if (!candidates) continue;
+                for (uint32_t row : *candidates) {
+                    if (!source.reads(row) || !filter.passes(row)) continue;
+                    bool equal = true;
+                    for (size_t k = 0; k < keys.size() && equal; ++k) {
+                        equal = HashJoin::valuesEqual(atom.table->columns[keys[k]], row,
+                                                      *bound[k], bindings.rows[slots[k]][r]);
+                    }
+                    if (!equal) continue;
+                    for (size_t s = 0; s < bindings.rows.size(); ++s) joined[s].push_back(bindings.rows[s][r]);
+                    joined.back().push_back(row);
+                }
+            }
+            bindings.atoms.push_back(next);
+            bindings.rows = move(joined);
+            bindings.size = bindings.rows.back().size();
+            bind(plan, bindings, next);
+        }
+        return project(plan, bindings);
+    }
+
+    Table run(const Plan& plan) const {
+        bool outer = false;
+        for (const auto& atom : plan.atoms) outer |= atom.nullable;
+        Bindings bindings = outer ? outerJoinAll(plan) : joinAll(plan);
+        if (plan.aggregates.empty()) return project(plan, bindings);
+        return aggregate(plan, bindings);
+    }
+
+    map<string, shared_ptr<const Table>> tables;    // By lower-cased name
+    map<string, OwnedTable> owned;                  // Tables changed in place, by name
+    map<string, map<vector<size_t>, RowIndex>> indexes;    // By table name, then columns
+};
+
+// ============================================================================
+// DATA LOADING
+// ============================================================================
+
+// A read-only memory mapping of a whole file, unmapped when the last
+// reference goes away
+class MappedFile {
+public:
+    // nullptr (with a message on cerr) if the file cannot be mapped
+    static shared_ptr<const MappedFile> open(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "Cannot open " << path << ": " << strerror(errno) << "\n";
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            cerr << "Cannot stat " << path << ": " << strerror(errno) << "\n";
+            ::close(fd);
+            return nullptr;
+        }
+        shared_ptr<MappedFile> file(new MappedFile());
+        file->length = st.st_size;
+        if (file->length > 0) {
+            void* addr = mmap(nullptr, file->length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                cerr << "Cannot map " << path << ": " << strerror(errno) << "\n";
+                ::close(fd);
+                return nullptr;
+            }
+            madvise(addr, file->length, MADV_SEQUENTIAL);
+            file->bytes = static_cast<const char*>(addr);
+        }
+        ::close(fd);
+        return file;
+    }
+
+    ~MappedFile() {
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile() = default;
+
+    const char* bytes = nullptr;
+    size_t length = 0;
+};
+
+// Loads delimited text (dbgen's pipe-separated .tbl files, or CSV) into
+// columnar tables. The file is mapped and cut into chunks at line
+// boundaries; the pool's threads parse the chunks into column pieces,
+// then concatenate the pieces column by column. Fields are matched to
+// the columns by position: an empty field is NULL, missing trailing
+// fields are NULL, and extra ones (such as dbgen's trailing '|') are
+// ignored. Lines must not contain newlines, not even in quoted CSV fields.
+class TableLoader {
+public:
+    struct ColumnSpec {
+        string name;
+        ColumnType type;
+    };
+
+    explicit TableLoader(unsigned n_threads = thread::hardware_concurrency()) : pool(n_threads) {}
+
+    // Column types of the TPC-H relations; dates are kept as their
+    // 'YYYY-MM-DD' text. Empty for any other relation.
+    static vector<ColumnSpec> tpchSchema(const string& relation) {
+        const ColumnType I = ColumnType::Int64, D = ColumnType::Double, S = ColumnType::String;
+        static const map<string, vector<ColumnSpec>> schema = {
+            {"customer", {{"c_custkey", I}, {"c_name", S}, {"c_address", S}, {"c_nationkey", I},
+                          {"c_phone", S}, {"c_acctbal", D}, {"c_mktsegment", S}, {"c_comment", S}}},
+            {"orders", {{"o_orderkey", I}, {"o_custkey", I}, {"o_orderstatus", S}, {"o_totalprice", D},
+                        {"o_orderdate", S}, {"o_orderpriority", S}, {"o_clerk", S},
+                        {"o_shippriority", I}, {"o_comment", S}}},
+            {"lineitem", {{"l_orderkey", I}, {"l_partkey", I}, {"l_suppkey", I}, {"l_linenumber", I},
+                          {"l_quantity", D}, {"l_extendedprice", D}, {"l_discount", D}, {"l_tax", D},
+                          {"l_returnflag", S}, {"l_linestatus", S}, {"l_shipdate", S},
+                          {"l_commitdate", S}, {"l_receiptdate", S}, {"l_shipinstruct", S},
+                          {"l_shipmode", S}, {"l_comment", S}}},
+            {"part", {{"p_partkey", I}, {"p_name", S}, {"p_mfgr", S}, {"p_brand", S}, {"p_type", S},
+                      {"p_size", I}, {"p_container", S}, {"p_retailprice", D}, {"p_comment", S}}},
+            {"supplier", {{"s_suppkey", I}, {"s_name", S}, {"s_address", S}, {"s_nationkey", I},
+                          {"s_phone", S}, {"s_acctbal", D}, {"s_comment", S}}},
+            {"partsupp", {{"ps_partkey", I}, {"ps_suppkey", I}, {"ps_availqty", I},
+                          {"ps_supplycost", D}, {"ps_comment", S}}},
+            {"nation", {{"n_nationkey", I}, {"n_name", S}, {"n_regionkey", I}, {"n_comment", S}}},
+            {"region", {{"r_regionkey", I}, {"r_name", S}, {"r_comment", S}}}
+        };
+        auto it = schema.find(Utils::toLower(relation));
+        return it != schema.end() ? it->second : vector<ColumnSpec>();
+    }
+
+    // Load a file with the delimiter its extension implies: ',' for .csv,
+    // '|' otherwise. nullptr if it cannot be read.
+    shared_ptr<const Table> load(const string& path, const vector<ColumnSpec>& columns) {
+        bool csv = path.size() >= 4 && Utils::toLower(path.substr(path.size() - 4)) == ".csv";
+        return load(path, columns, csv ? ',' : '|');
+    }
+
+    // With ',' as the delimiter (CSV), fields may be double-quoted (""
+    // for a quote), and a first line whose numeric fields do not parse is
+    // taken for a header and skipped. Other delimiters (dbgen files) have
+    // no header: a first line that does not parse is data like any other.
+    shared_ptr<const Table> load(const string& path, const vector<ColumnSpec>& columns, char delimiter) {
+        shared_ptr<const MappedFile> file = MappedFile::open(path);
+        if (!file) return nullptr;
+        const char* begin = file->data();
+        const char* end = begin + file->size();
+        if (begin && delimiter == ',' && isHeader(begin, end, columns, delimiter)) {
+            begin = lineEnd(begin, end);
+        }
+
+        // Chunk boundaries: every chunk but the first starts after a newline
+        size_t n_chunks = max<size_t>(1, min<size_t>(pool.size() * 4, (end - begin) / MIN_CHUNK));
+        vector<const char*> starts{begin};
+        for (size_t c = 1; c < n_chunks; ++c) {
+            const char* start = lineEnd(max(begin + (end - begin) * c / n_chunks, starts.back()), end);
+            starts.push_back(start);
+        }
+        starts.push_back(end);
+
+        vector<vector<Column>> pieces(n_chunks);
+        atomic<size_t> bad_fields{0};
+        pool.parallelFor(n_chunks, [&](size_t c, unsigned) {
+            pieces[c] = parseChunk(starts[c], starts[c + 1], columns, delimiter, bad_fields);
+        });
+
+        auto table = make_shared<Table>();
+        table->names.resize(columns.size());
+        table->columns.resize(columns.size());
+        pool.parallelFor(columns.size(), [&](size_t col, unsigned) {
+            ColumnBuilder builder(columns[col].type);
+            for (const auto& piece : pieces) builder.appendColumn(piece[col]);
+            table->names[col] = columns[col].name;
+            table->columns[col] = builder.finish();
+        });
+        table->n_rows = columns.empty() ? 0 : table->columns[0].length;
+        if (bad_fields > 0) {
+            cerr << path << ": " << bad_fields << " numeric fields did not parse and were loaded as NULL\n";
+        }
+        return table;
+    }
+
+    // Load each TPC-H relation found in `directory` as <relation>.tbl or
+    // <relation>.csv and register it with the executor. Returns the
+    // number of tables loaded.
+    size_t loadTPCH(const string& directory, ColumnarExecutor& executor) {
+        size_t loaded = 0;
+        for (const char* relation : {"customer", "orders", "lineitem", "part", "supplier",
+                                      "partsupp", "nation", "region"}) {
+            for (const char* extension : {".tbl", ".csv"}) {
+                string path = directory + "/" + relation + extension;
+                struct stat st;
+                if (stat(path.c_str(), &st) != 0) continue;
+                shared_ptr<const Table> table = load(path, tpchSchema(relation));
+                if (table) {
+                    executor.addTable(relation, table);
+                    ++loaded;
+                }
+                break;
+            }
         }
+        return loaded;
     }
+
+private:
+    static constexpr size_t MIN_CHUNK = 1 << 20;
+
+    // Start of the line after the one containing `p`
+    static const char* lineEnd(const char* p, const char* end) {
+        const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+        return newline ? newline + 1 : end;
+    }
+
+    // The field starting at `p`, unquoting a CSV field into `scratch`;
+    // returns the position just past it
+    static const char* nextField(const char* p, const char* stop, char delimiter,
+                                 string& scratch, string_view& field) {
+        if (delimiter == ',' && p < stop && *p == '"') {
+            scratch.clear();
+            const char* q = p + 1;
+            while (q < stop) {
+                if (*q == '"') {
+                    if (q + 1 < stop && q[1] == '"') {
+                        scratch += '"';
+                        q += 2;
+                        continue;
+                    }
+                    ++q;
+                    break;
+                }
+                scratch += *q++;
+            }
+            field = scratch;
+            const char* after = static_cast<const char*>(memchr(q, delimiter, stop - q));
+            return after ? after : stop;
+        }
+        const char* after = static_cast<const char*>(memchr(p, delimiter, stop - p));
+        if (!after) after = stop;
+        field = string_view(p, after - p);
+        return after;
+    }
+
+    static bool isHeader(const char* begin, const char* end, const vector<ColumnSpec>& columns,
+                         char delimiter) {
+        const char* stop = lineEnd(begin, end);
+        string scratch;
+        const char* p = begin;
+        for (size_t col = 0; col < columns.size() && p < stop; ++col) {
+            string_view field;
+            const char* after = nextField(p, stop, delimiter, scratch, field);
+            while (!field.empty() && (field.back() == '\n' || field.back() == '\r')) field.remove_suffix(1);
+            if (columns[col].type != ColumnType::String && !field.empty()) {
+                ColumnBuilder parse(columns[col].type);
+                if (!parse.appendText(field)) return true;
+            }
+            p = after + 1;
+        }
+        return false;
+    }
+
+    static vector<Column> parseChunk(const char* begin, const char* end,
+                                     const vector<ColumnSpec>& columns, char delimiter,
+                                     atomic<size_t>& bad_fields) {
+        vector<ColumnBuilder> builders;
+        for (const auto& spec : columns) builders.emplace_back(spec.type);
+        // Size the builders for lines as long as the first one
+        size_t first_line = lineEnd(begin, end) - begin;
+        if (first_line > 0) {
+            for (auto& builder : builders) builder.reserve((end - begin) / first_line + 1);
+        }
+        string scratch;
+        size_t bad = 0;
+        for (const char* line = begin; line < end;) {
+            const char* next = lineEnd(line, end);
+            const char* stop = next;
+            while (stop > line && (stop[-1] == '\n' || stop[-1] == '\r')) --stop;
+            if (stop == line) {     // Blank line
+                line = next;
+                continue;
+            }
+            size_t col = 0;
+            for (const char* p = line; col < columns.size();) {
+                string_view field;
+                const char* after = nextField(p, stop, delimiter, scratch, field);
+                bad += !builders[col++].appendText(field);
+                if (after >= stop) break;
+                p = after + 1;
+            }
+            for (; col < columns.size(); ++col) builders[col].appendNull();
+            line = next;
+        }
+        bad_fields += bad;
+        vector<Column> piece;
+        for (auto& builder : builders) piece.push_back(builder.finish());
+        return piece;
+    }
+
+    ThreadPool pool;
+};
+
+// Columnar file of a table, read through a mapping without decoding:
+//
+//   "MCCOLUMN"  column sections, each 8-byte aligned  footer  trailer
+//
+// A numeric column is its array of values; a string column is dictionary
+// encoded as a uint32 code per row, the dictionary's offsets (uint64,
+// entries + 1) and its characters. Either may be followed by a validity
+// byte per row. The footer holds the row count and, per column, its name,
+// type and section offsets, all as uint64; the trailer is the footer's
+// offset and the magic again. Values are stored in native byte order.
+class ColumnarFile {
+public:
+    // Write `table` to `path`, replacing it only once complete. False
+    // (with a message on cerr) on failure.
+    static bool write(const Table& table, const string& path) {
+        string tmp = path + ".tmp";
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if (!out) {
+            cerr << "Cannot create " << tmp << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        Writer w{out, 0};
+        w.bytes(MAGIC, sizeof MAGIC);
+        vector<uint64_t> footer{table.rows(), table.columns.size()};
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            const Column& column = table.columns[c];
+            size_t n = column.length;
+            SectionOffsets offsets;
+            if (column.type == ColumnType::String) {
+                vector<uint32_t> codes(n);
+                vector<uint64_t> dictionary{0};
+                string chars;
+                unordered_map<string_view, uint32_t> entries;
+                for (size_t row = 0; row < n; ++row) {
+                    string_view value = column.isNull(row) ? string_view() : column.stringAt(row);
+                    auto [it, added] = entries.emplace(value, entries.size());
+                    if (added) {
+                        chars.append(value.data(), value.size());
+                        dictionary.push_back(chars.size());
+                    }
+                    codes[row] = it->second;
+                }
+                offsets.values = w.section(codes.data(), n * sizeof(uint32_t));
+                offsets.dictionary = w.section(dictionary.data(), dictionary.size() * sizeof(uint64_t));
+                offsets.chars = w.section(chars.data(), chars.size());
+                offsets.entries = entries.size();
+            } else {
+                offsets.values = w.section(column.data, n * 8);
+            }
+            if (column.validity) offsets.validity = w.section(column.validity, n);
+
+            footer.push_back(table.names[c].size());
+            for (size_t i = 0; i < table.names[c].size(); i += 8) {
+                uint64_t word = 0;
+                memcpy(&word, table.names[c].data() + i, min<size_t>(8, table.names[c].size() - i));
+                footer.push_back(word);
+            }
+            footer.insert(footer.end(), {(uint64_t)column.type, offsets.values, offsets.validity,
+                                         offsets.dictionary, offsets.chars, offsets.entries});
+        }
+        uint64_t footer_offset = w.section(footer.data(), footer.size() * sizeof(uint64_t));
+        w.bytes(&footer_offset, sizeof footer_offset);
+        w.bytes(MAGIC, sizeof MAGIC);
+        out.close();
+        if (!out || rename(tmp.c_str(), path.c_str()) != 0) {
+            cerr << "Cannot write " << path << ": " << strerror(errno) << "\n";
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Map the file at `path`; its columns point into the mapping, which
+    // stays until the last of them is gone. nullptr (with a message on
+    // cerr) if the file is missing or malformed.
+    static shared_ptr<const Table> read(const string& path) {
+        shared_ptr<const MappedFile> file = MappedFile::open(path);
+        if (!file) return nullptr;
+        auto malformed = [&]() -> shared_ptr<const Table> {
+            cerr << path << " is not a valid columnar file\n";
+            return nullptr;
+        };
+        const char* base = file->data();
+        size_t size = file->size();
+        if (size < 3 * sizeof MAGIC || memcmp(base, MAGIC, sizeof MAGIC) != 0 ||
+            memcmp(base + size - sizeof MAGIC, MAGIC, sizeof MAGIC) != 0) {
+            return malformed();
+        }
+        uint64_t footer_offset;
+        memcpy(&footer_offset, base + size - 2 * sizeof MAGIC, sizeof footer_offset);
+        size_t footer_end = size - 2 * sizeof MAGIC;
+        if (footer_offset < sizeof MAGIC || footer_offset > footer_end || footer_offset % 8 != 0) {
+            return malformed();
+        }
+        const uint64_t* footer = reinterpret_cast<const uint64_t*>(base + footer_offset);
+        size_t footer_words = (footer_end - footer_offset) / sizeof(uint64_t);
+        size_t word = 0;
+        auto next = [&](uint64_t& value) {
+            if (word >= footer_words) return false;
+            value = footer[word++];
+            return true;
+        };
+        // Does [offset, offset + length) lie within the column sections?
+        auto inside = [&](uint64_t offset, uint64_t length) {
+            return offset >= sizeof MAGIC && offset % 8 == 0 && offset <= footer_offset &&
+                   length <= footer_offset - offset;
+        };
+
+        uint64_t n_rows, n_columns;
+        if (!next(n_rows) || !next(n_columns) || n_rows > UINT32_MAX) return malformed();
+        auto table = make_shared<Table>();
+        for (uint64_t c = 0; c < n_columns; ++c) {
+            uint64_t name_length, type;
+            SectionOffsets offsets;
+            if (!next(name_length) || name_length > (footer_words - word) * 8) return malformed();
+            string name(reinterpret_cast<const char*>(footer + word), name_length);
+            word += (name_length + 7) / 8;
+            if (!next(type) || !next(offsets.values) || !next(offsets.validity) ||
+                !next(offsets.dictionary) || !next(offsets.chars) || !next(offsets.entries) ||
+                type > (uint64_t)ColumnType::String) {
+                return malformed();
+            }
+
+            Column column;
+            column.type = (ColumnType)type;
+            column.length = n_rows;
+            column.owner = file;
+            if (offsets.validity) {
+                if (!inside(offsets.validity, n_rows)) return malformed();
+                column.validity = reinterpret_cast<const uint8_t*>(base + offsets.validity);
+            }
+            if (column.type != ColumnType::String) {
+                if (!inside(offsets.values, n_rows * 8)) return malformed();
+                column.data = base + offsets.values;
+            } else {
+                if (!inside(offsets.values, n_rows * sizeof(uint32_t)) ||
+                    offsets.entries >= UINT32_MAX ||
+                    !inside(offsets.dictionary, (offsets.entries + 1) * sizeof(uint64_t))) {
+                    return malformed();
+                }
+                column.codes = reinterpret_cast<const uint32_t*>(base + offsets.values);
+                column.data = base + offsets.dictionary;
+                column.chars = base + offsets.chars;
+                // Codes and offsets are checked once here, so that reads
+                // need no bounds checks
+                const uint64_t* dictionary = static_cast<const uint64_t*>(column.data);
+                if (dictionary[0] != 0 || !inside(offsets.chars, dictionary[offsets.entries])) {
+                    return malformed();
+                }
+                for (uint64_t e = 0; e < offsets.entries; ++e) {
+                    if (dictionary[e] > dictionary[e + 1]) return malformed();
+                }
+                for (uint64_t row = 0; row < n_rows; ++row) {
+                    if (column.codes[row] >= offsets.entries) return malformed();
+                }
+            }
+            table->addColumn(name, move(column));
+        }
+        table->n_rows = n_rows;
+        return table;
+    }
+
+    // Write the rows of catalog view `view_idx` and record the file in the
+    // catalog
+    static bool persistView(ViewCatalog& catalog, int view_idx, const Table& rows,
+                            const string& path) {
+        if (!write(rows, path)) return false;
+        catalog.setViewStorage(view_idx, path);
+        return true;
+    }
+
+    // Map the file of every live catalog view that has one and register it
+    // with the executor under the view's name. Returns the number of views
+    // opened.
+    static size_t openViews(const ViewCatalog& catalog, ColumnarExecutor& executor) {
+        auto lock = catalog.readLock();
+        size_t opened = 0;
+        for (size_t v = 0; v < catalog.views.size(); ++v) {
+            if (!catalog.live[v] || catalog.storage[v].empty()) continue;
+            shared_ptr<const Table> rows = read(catalog.storage[v]);
+            if (!rows) continue;
+            executor.addTable(catalog.views[v].name, rows);
+            ++opened;
+        }
+        return opened;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'M', 'C', 'C', 'O', 'L', 'U', 'M', 'N'};
+
+    // File offsets of one column's sections; 0 where absent
+    struct SectionOffsets {
+        uint64_t values = 0;
+        uint64_t validity = 0;
+        uint64_t dictionary = 0;
+        uint64_t chars = 0;
+        uint64_t entries = 0;   // Dictionary size
+    };
+
+    struct Writer {
+        ofstream& out;
+        uint64_t position;
+
+        void bytes(const void* data, size_t n) {
+            out.write(static_cast<const char*>(data), n);
+            position += n;
+        }
+
+        // Write an 8-byte aligned section; returns its offset
+        uint64_t section(const void* data, size_t n) {
+            static const char zeros[8] = {};
+            bytes(zeros, (8 - position % 8) % 8);
+            uint64_t offset = position;
+            bytes(data, n);
+            return offset;
+        }
+    };
+};
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+// HyperLogLog distinct-value sketch: 2^PRECISION one-byte registers, a
+// relative error around 1.04 / sqrt(2^PRECISION) (0.8%). Sketches of
+// parts of a column merge into the sketch of the whole.
+class HyperLogLog {
+public:
+    static constexpr int PRECISION = 14;
+
+    HyperLogLog() : registers(size_t(1) << PRECISION, 0) {}
+
+    // `hash` must be well mixed in all 64 bits
+    void add(uint64_t hash) {
+        size_t index = hash >> (64 - PRECISION);
+        uint64_t rest = hash << PRECISION;
+        uint8_t rank = rest == 0 ? 64 - PRECISION + 1 : __builtin_clzll(rest) + 1;
+        registers[index] = max(registers[index], rank);
+    }
+
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < registers.size(); ++i) {
+            registers[i] = max(registers[i], other.registers[i]);
+        }
+    }
+
+    double estimate() const {
+        double m = registers.size();
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += ldexp(1.0, -r);
+            zeros += r == 0;
+        }
+        double raw = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        // Small cardinalities: linear counting over the empty registers
+        if (raw <= 2.5 * m && zeros > 0) return m * log(m / zeros);
+        return raw;
+    }
+
+private:
+    vector<uint8_t> registers;
 };
 
+// Collects ColumnStatistics for every column of a table in one pass. Row
+// ranges are handed to the pool's threads; each thread keeps, per column,
+// a HyperLogLog sketch, the min/max, counts and a fixed-size reservoir
+// sample for the histogram, and the threads' results are merged at the
+// end. Memory is bounded by threads x columns x (sketch + sample),
+// whatever the table size, so mapped multi-GB tables only stream through.
+class StatisticsBuilder {
+public:
+    static constexpr size_t HISTOGRAM_BUCKETS = 32;
+    static constexpr size_t SAMPLE_SIZE = 4096;     // Per thread and column
+
+    explicit StatisticsBuilder(unsigned n_threads = thread::hardware_concurrency())
+        : pool(n_threads) {}
+
+    vector<ColumnStatistics> build(const Table& table) {
+        size_t n_rows = table.rows();
+        size_t n_chunks = (n_rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+        vector<vector<Partial>> partials(pool.size());
+        for (unsigned w = 0; w < pool.size(); ++w) {
+            for (size_t c = 0; c < table.columns.size(); ++c) partials[w].emplace_back(w * 7919 + c);
+        }
+        pool.parallelFor(n_chunks, [&](size_t chunk, unsigned worker) {
+            size_t begin = chunk * CHUNK_ROWS, end = min(n_rows, begin + CHUNK_ROWS);
+            for (size_t c = 0; c < table.columns.size(); ++c) {
+                scan(table.columns[c], begin, end, partials[worker][c]);
+            }
+        });
+
+        vector<ColumnStatistics> result;
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            vector<Partial*> parts;
+            for (auto& worker : partials) parts.push_back(&worker[c]);
+            result.push_back(combine(parts, n_rows));
+        }
+        return result;
+    }
+
+    // Statistics of a view from its materialized rows (the view's head
+    // columns, then its aggregates), keyed by view variable as the cost
+    // model reads them
+    ViewStatistics viewStatistics(const ConjunctiveQuery& view, const Table& rows) {
+        vector<ColumnStatistics> columns = build(rows);
+        vector<int> vars;
+        for (const auto& t : view.head) vars.push_back(t.id);
+        for (const auto& agg : view.aggregates) vars.push_back(agg.output);
+        ViewStatistics stats;
+        stats.row_count = rows.rows();
+        for (size_t c = 0; c < columns.size() && c < vars.size(); ++c) {
+            stats.distinct_counts[vars[c]] = columns[c].distinct;
+            stats.column_widths[vars[c]] = columns[c].width;
+            stats.columns[vars[c]] = columns[c];
+        }
+        return stats;
+    }
+
+    // Collect the statistics of every live catalog view materialized in
+    // the executor and store them with the view. Returns the number of
+    // views updated.
+    size_t collect(ViewCatalog& catalog, const ColumnarExecutor& executor) {
+        vector<pair<int, ViewStatistics>> collected;
+        {
+            auto lock = catalog.readLock();
+            for (size_t v = 0; v < catalog.views.size(); ++v) {
+                if (!catalog.live[v]) continue;
+                shared_ptr<const Table> rows = executor.table(catalog.views[v].name);
+                if (rows) collected.push_back({v, viewStatistics(catalog.views[v], *rows)});
+            }
+        }
+        for (auto& [v, stats] : collected) catalog.setViewStatistics(v, stats);
+        return collected.size();
+    }
+
+private:
+    static constexpr size_t CHUNK_ROWS = 1 << 16;
+
+    // One thread's view of one column
+    struct Partial {
+        HyperLogLog sketch;
+        double nulls = 0;
+        double values = 0;      // Non-NULL rows seen
+        double bytes = 0;
+        bool has_range = false;
+        double min = 0;
+        double max = 0;
+        vector<double> sample;
+        mt19937_64 rng;
+
+        explicit Partial(uint64_t seed) : rng(seed) {}
+    };
+
+    static uint64_t fmix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        return x ^ (x >> 33);
+    }
+
+    static void scan(const Column& column, size_t begin, size_t end, Partial& p) {
+        for (size_t row = begin; row < end; ++row) {
+            if (column.isNull(row)) {
+                ++p.nulls;
+                continue;
+            }
+            uint64_t seen = p.values++;
+            if (column.type == ColumnType::String) {
+                string_view value = column.stringAt(row);
+                p.sketch.add(fmix(hash<string_view>()(value)));
+                p.bytes += value.size();
+                continue;
+            }
+            double value = column.numberAt(row);
+            uint64_t bits;
+            if (column.type == ColumnType::Int64) {
+                bits = column.intAt(row);
+            } else {
+                double normalized = value == 0 ? 0 : value;     // -0.0 is 0.0
+                memcpy(&bits, &normalized, sizeof bits);
+            }
+            p.sketch.add(fmix(bits));
+            p.bytes += 8;
+            if (!p.has_range || value < p.min) p.min = value;
+            if (!p.has_range || value > p.max) p.max = value;
+            p.has_range = true;
+            // Reservoir sampling: row k of the stream replaces a sampled
+            // row with probability SAMPLE_SIZE / (k + 1)
+            if (p.sample.size() < SAMPLE_SIZE) {
+                p.sample.push_back(value);
+            } else {
+                uint64_t slot = p.rng() % (seen + 1);
+                if (slot < SAMPLE_SIZE) p.sample[slot] = value;
+            }
+        }
+    }
+
+    ColumnStatistics combine(vector<Partial*>& parts, size_t n_rows) {
+        ColumnStatistics stats;
+        stats.rows = n_rows;
+        HyperLogLog sketch;
+        double values = 0, bytes = 0;
+        for (Partial* p : parts) {
+            sketch.merge(p->sketch);
+            stats.nulls += p->nulls;
+            values += p->values;
+            bytes += p->bytes;
+            if (!p->has_range) continue;
+            if (!stats.has_range || p->min < stats.min) stats.min = p->min;
+            if (!stats.has_range || p->max > stats.max) stats.max = p->max;
+            stats.has_range = true;
+        }
+        stats.distinct = values == 0 ? 0 : min(sketch.estimate(), values);
+        stats.width = values == 0 ? 0 : bytes / values;
+        if (!stats.has_range) return stats;
+
+        // Draw from each thread's reservoir in proportion to the rows it
+        // saw, so that the merged sample stays uniform
+        vector<double> sample;
+        for (Partial* p : parts) {
+            size_t take = min(p->sample.size(), (size_t)ceil(SAMPLE_SIZE * p->values / values));
+            shuffle(p->sample.begin(), p->sample.end(), p->rng);
+            sample.insert(sample.end(), p->sample.begin(), p->sample.begin() + take);
+        }
+        sort(sample.begin(), sample.end());
+        stats.bounds.push_back(stats.min);
+        for (size_t b = 1; b < HISTOGRAM_BUCKETS; ++b) {
+            stats.bounds.push_back(sample[b * (sample.size() - 1) / HISTOGRAM_BUCKETS]);
+        }
+        stats.bounds.push_back(stats.max);
+        return stats;
+    }
+
+    ThreadPool pool;
+};
 
 void paperExample(SQLToConjunctiveQuery converter) {
     // Example 6: TPC-H style paper query
     cout << "\n\n### Example 5: TPC-H Style Query ###\n";
     cout << "------------------------------------\n";
 
-    string sql_q = "SELECT c.name, s.name, n.name "
+    string sql_q = "SELECT c.c_name, s.s_name, n.n_name "
                         "FROM Supplier s, Customer c, Nation n "
-                        "WHERE c.nationkey = s.nationkey AND s.nationkey = n.nationkey AND n.nationkey = c.nationkey";
-    string sql_v2 = "SELECT c.nationkey, c.name, n.name FROM Customer c, Nation n "
-                         "WHERE c.nationkey = n.nationkey";
-    string sql_v1 = "SELECT c.nationkey, c.name FROM Customer c";
-    string sql_v3 = "SELECT c.nationkey, c.name, s.name FROM Customer c, Supplier s "
-                         "WHERE c.nationkey = s.nationkey";
+                        "WHERE c.c_nationkey = s.s_nationkey AND s.s_nationkey = n.n_nationkey AND n.n_nationkey = c.c_nationkey";
+    string sql_v2 = "SELECT c.c_nationkey, c.c_name, n.n_name FROM Customer c, Nation n "
+                         "WHERE c.c_nationkey = n.n_nationkey";
+    string sql_v1 = "SELECT c.c_nationkey, c.c_name FROM Customer c";
+    string sql_v3 = "SELECT c.c_nationkey, c.c_name, s.s_name FROM Customer c, Supplier s "
+                         "WHERE c.c_nationkey = s.s_nationkey";
 
     cout << "Query SQL:\n  " << sql_q << "\n";
     cout << "View V2 SQL: " << sql_v2 << "\n";
     cout << "View V1 SQL: " << sql_v1 << "\n";
     cout << "View V3 SQL: " << sql_v3 << "\n\n";
 
-    MiniCon minicom;
-    ConjunctiveQuery q = converter.convert(sql_q, "Q");
-    ConjunctiveQuery v2 = converter.convert(sql_v2, "V2");
-    ConjunctiveQuery v1 = converter.convert(sql_v1, "V1");
-    ConjunctiveQuery v3 = converter.convert(sql_v3, "V3");
+    // Views are converted and indexed once; any number of queries can
+    // then be rewritten against the catalog
+    auto catalog = make_shared<ViewCatalog>(converter.getSymbols());
+    catalog->addView(sql_v2, "V2");
+    catalog->addView(sql_v1, "V1");
+    catalog->addView(sql_v3, "V3");
 
+    MiniCon minicom(catalog);
+    ConjunctiveQuery q = catalog->converter().convert(sql_q, "Q");
     minicom.setQuery(q);
-    minicom.addView(v2);
-    minicom.addView(v1);
-    minicom.addView(v3);
 
     cout << "Converted to Conjunctive Queries:\n";
     minicom.printQuery();
@@ -851,8 +6089,8 @@ void paperExample(SQLToConjunctiveQuery converter) {
     cout << "\n=== Rewritings Found: " << rewritings.size() << " ===\n";
     for (size_t i = 0; i < rewritings.size(); ++i) {
         cout << "\nRewriting " << i + 1 << ":\n";
-        cout << "  Conjunctive form: " << rewritings[i].toString(minicom.views) << "\n";
-        cout << "  SQL form: " << rewritings[i].toSQL(minicom.views, q) << "\n";
+        cout << "  Conjunctive form: " << rewritings[i].toString(catalog->views) << "\n";
+        cout << "  SQL form: " << rewritings[i].toSQL(catalog->views, q) << "\n";
     }
 }
 
@@ -860,6 +6098,8 @@ void paperExample(SQLToConjunctiveQuery converter) {
 // MAIN - EXAMPLES
 // ============================================================================
 
+// minicon_test.cpp includes this file with MINICON_NO_MAIN defined
+#ifndef MINICON_NO_MAIN
 int main() {
     SQLToConjunctiveQuery converter;
     
@@ -1049,3 +6289,4 @@ int main() {
     
     return 0;
 }
+#endif
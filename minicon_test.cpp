@@ -2,6 +2,11 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <filesystem>
+
+// Build with: g++ -std=c++17 -O2 -pthread minicon_test.cpp -o minicon_test
+#define MINICON_NO_MAIN
+#include "minicon.cpp"
 
 /*
  * TPC-H Schema Reference:
@@ -979,6 +984,7 @@ std::vector<TestCase> generateTestCases() {
         true
     });
     
+    // No view exports c_phone
     testcases.push_back({72, "Incomplete view - missing head variable",
         "SELECT c.c_name, c.c_phone FROM Customer c",
         {
@@ -988,7 +994,7 @@ std::vector<TestCase> generateTestCases() {
             "SELECT c.c_custkey, c.c_comment FROM Customer c",
             "SELECT c.c_name, c.c_address FROM Customer c"
         },
-        true
+        false
     });
     
     testcases.push_back({73, "Orders totalprice and status",
@@ -1360,6 +1366,257 @@ std::vector<TestCase> generateTestCases() {
         true
     });
     
+    // Test Case 101: View range equals the query range
+    testcases.push_back({101, "Range predicate matched by view range",
+        "SELECT c.c_name, n.n_name FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey AND c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name, c.c_nationkey FROM Customer c WHERE c.c_acctbal < 1000",
+            "SELECT n.n_nationkey, n.n_name FROM Nation n"
+        },
+        true
+    });
+    
+    // Test Case 102: View range is disjoint from the query range
+    testcases.push_back({102, "Range predicate disjoint from view range",
+        "SELECT c.c_name, n.n_name FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey AND c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name, c.c_nationkey FROM Customer c WHERE c.c_acctbal > 2500",
+            "SELECT n.n_nationkey, n.n_name FROM Nation n"
+        },
+        false
+    });
+    
+    // Test Case 103: Wider view range, compared column not exported
+    testcases.push_back({103, "Wider view range without the compared column",
+        "SELECT c.c_name FROM Customer c WHERE c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name FROM Customer c WHERE c.c_acctbal < 2500",
+            "SELECT c.c_name, c.c_nationkey FROM Customer c"
+        },
+        false
+    });
+    
+    // Test Case 104: Wider view range, compared column exported for filtering
+    testcases.push_back({104, "Wider view range with the compared column",
+        "SELECT c.c_name FROM Customer c WHERE c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name, c.c_acctbal FROM Customer c WHERE c.c_acctbal < 2500"
+        },
+        true
+    });
+    
+    // Test Case 105: BETWEEN ranges inside the query ranges lose answers
+    testcases.push_back({105, "BETWEEN view ranges narrower than query ranges",
+        "SELECT c.c_name, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey AND c.c_acctbal < 5000 AND s.s_acctbal > 9999",
+        {
+            "SELECT c.c_name, c.c_nationkey, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey AND c.c_acctbal BETWEEN 4001 AND 4500 AND s.s_acctbal > 10000",
+            "SELECT c.c_name, c.c_nationkey, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey AND c.c_acctbal BETWEEN 4501 AND 7500 AND s.s_acctbal BETWEEN 5000 AND 20000"
+        },
+        false
+    });
+    
+    // Test Case 106: Lower-case AND, reversed operand order, equality constant
+    testcases.push_back({106, "Mixed-case predicates and constant equality",
+        "SELECT p.p_name FROM Part p WHERE p.p_size = 15 and 100 > p.p_retailprice",
+        {
+            "SELECT p.p_name, p.p_retailprice FROM Part p WHERE p.p_size = 15",
+            "SELECT p.p_name FROM Part p WHERE p.p_size = 20"
+        },
+        true
+    });
+    
+    // Test Case 107: Q3 of test_queries.sql over outer-join views
+    testcases.push_back({107, "Outer-join views cover their null-supplied sides",
+        "SELECT c_name, n_name, s_name FROM customer, nation, supplier WHERE c_nationkey = n_nationkey AND n_nationkey = s_nationkey AND c_acctbal < 1000",
+        {
+            "SELECT c_name, c_nationkey FROM customer WHERE c_acctbal < 1000",
+            "SELECT c_name, c_nationkey, s_name, s_nationkey FROM customer LEFT OUTER JOIN supplier ON c_nationkey = s_nationkey AND c_acctbal < 2500",
+            "SELECT c_name, c_nationkey, n_name, n_nationkey FROM customer FULL OUTER JOIN nation ON c_nationkey = n_nationkey AND c_acctbal > 2500"
+        },
+        true
+    });
+    
+    // Test Case 108: Preserved side of a left outer join on its own
+    testcases.push_back({108, "Left outer join view keeps every preserved row",
+        "SELECT c.c_name FROM Customer c",
+        {
+            "SELECT c.c_name, s.s_name FROM Customer c LEFT OUTER JOIN Supplier s ON c.c_nationkey = s.s_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 109: Inner join answered from a left outer join view
+    testcases.push_back({109, "Inner join through an outer-join view",
+        "SELECT c.c_name, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey",
+        {
+            "SELECT c.c_name, s.s_name FROM Customer c LEFT JOIN Supplier s ON c.c_nationkey = s.s_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 110: Padded rows cannot be told apart
+    testcases.push_back({110, "Null-supplied side exports no column of its own",
+        "SELECT c.c_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey",
+        {
+            "SELECT c.c_name, c.c_nationkey FROM Customer c LEFT OUTER JOIN Supplier s ON c.c_nationkey = s.s_nationkey"
+        },
+        false
+    });
+    
+    // Test Case 111: ON predicates do not filter the preserved side
+    testcases.push_back({111, "ON predicate ignored for preserved rows",
+        "SELECT c.c_name FROM Customer c WHERE c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name, c.c_acctbal, s.s_name FROM Customer c LEFT OUTER JOIN Supplier s ON c.c_nationkey = s.s_nationkey AND c.c_acctbal > 2500"
+        },
+        true
+    });
+    
+    // Test Case 112: ON predicates do filter the joined rows
+    testcases.push_back({112, "ON predicate disjoint from the query range",
+        "SELECT c.c_name, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey AND c.c_acctbal < 1000",
+        {
+            "SELECT c.c_name, c.c_acctbal, s.s_name FROM Customer c LEFT OUTER JOIN Supplier s ON c.c_nationkey = s.s_nationkey AND c.c_acctbal > 2500"
+        },
+        false
+    });
+    
+    // Test Case 113: Right outer join, preserved side on the right
+    testcases.push_back({113, "Right outer join view keeps every preserved row",
+        "SELECT c.c_name, c.c_phone FROM Customer c",
+        {
+            "SELECT c.c_name, c.c_phone, s.s_name FROM Supplier s RIGHT OUTER JOIN Customer c ON s.s_nationkey = c.c_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 114: Roll a finer aggregate view up to the query's groups
+    testcases.push_back({114, "SUM rolled up from a finer grouping",
+        "SELECT n.n_name, SUM(c.c_acctbal) FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey GROUP BY n.n_name",
+        {
+            "SELECT n.n_name, c.c_mktsegment, SUM(c.c_acctbal) AS total, COUNT(*) AS cnt FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey GROUP BY n.n_name, c.c_mktsegment"
+        },
+        true
+    });
+    
+    // Test Case 115: Same grouping, read the view rows as they are
+    testcases.push_back({115, "COUNT(*) from a view with the same grouping",
+        "SELECT c.c_nationkey, COUNT(*) FROM Customer c GROUP BY c.c_nationkey",
+        {
+            "SELECT c.c_nationkey, COUNT(*) AS cnt FROM Customer c GROUP BY c.c_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 116: A coarser view cannot be split into finer groups
+    testcases.push_back({116, "View grouping coarser than the query's",
+        "SELECT c.c_nationkey, c.c_mktsegment, COUNT(*) FROM Customer c GROUP BY c.c_nationkey, c.c_mktsegment",
+        {
+            "SELECT c.c_nationkey, COUNT(*) AS cnt FROM Customer c GROUP BY c.c_nationkey"
+        },
+        false
+    });
+    
+    // Test Case 117: MIN and MAX roll up by themselves
+    testcases.push_back({117, "MIN and MAX rolled up",
+        "SELECT c.c_mktsegment, MIN(c.c_acctbal), MAX(c.c_acctbal) FROM Customer c GROUP BY c.c_mktsegment",
+        {
+            "SELECT c.c_mktsegment, c.c_nationkey, MIN(c.c_acctbal) AS lo, MAX(c.c_acctbal) AS hi FROM Customer c GROUP BY c.c_mktsegment, c.c_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 118: The view lacks the aggregate the query needs
+    testcases.push_back({118, "Aggregate missing from the view",
+        "SELECT c.c_nationkey, SUM(c.c_acctbal) FROM Customer c GROUP BY c.c_nationkey",
+        {
+            "SELECT c.c_nationkey, COUNT(*) AS cnt FROM Customer c GROUP BY c.c_nationkey"
+        },
+        false
+    });
+    
+    // Test Case 119: Plain views joined and aggregated again
+    testcases.push_back({119, "Aggregate query over projection views",
+        "SELECT n.n_name, COUNT(*) FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey GROUP BY n.n_name",
+        {
+            "SELECT c.c_custkey, c.c_nationkey FROM Customer c",
+            "SELECT n.n_nationkey, n.n_name FROM Nation n"
+        },
+        true
+    });
+    
+    // Test Case 120: A view join would change the counts
+    testcases.push_back({120, "Extra join in the view changes multiplicities",
+        "SELECT c.c_nationkey, COUNT(*) FROM Customer c GROUP BY c.c_nationkey",
+        {
+            "SELECT c.c_nationkey, c.c_name FROM Customer c, Orders o WHERE c.c_custkey = o.o_custkey"
+        },
+        false
+    });
+    
+    // Test Case 121: Filter on a grouping column before rolling up
+    testcases.push_back({121, "Range on a grouping column filtered on the view",
+        "SELECT c.c_nationkey, SUM(c.c_acctbal) FROM Customer c WHERE c.c_nationkey < 10 GROUP BY c.c_nationkey",
+        {
+            "SELECT c.c_nationkey, SUM(c.c_acctbal) AS total FROM Customer c GROUP BY c.c_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 122: Aggregated rows cannot be filtered afterwards
+    testcases.push_back({122, "Range on an aggregated column the view lacks",
+        "SELECT c.c_nationkey, SUM(c.c_acctbal) FROM Customer c WHERE c.c_acctbal > 0 GROUP BY c.c_nationkey",
+        {
+            "SELECT c.c_nationkey, SUM(c.c_acctbal) AS total FROM Customer c GROUP BY c.c_nationkey"
+        },
+        false
+    });
+    
+    // Test Case 123: SUM of a grouping column, weighted by the group count
+    testcases.push_back({123, "SUM of a view grouping column",
+        "SELECT SUM(c.c_nationkey) FROM Customer c",
+        {
+            "SELECT c.c_nationkey, COUNT(*) AS cnt FROM Customer c GROUP BY c.c_nationkey"
+        },
+        true
+    });
+    
+    // Test Case 124: The view keeps a range the query does not have
+    testcases.push_back({124, "View range on a column the query leaves open",
+        "SELECT c.c_name FROM Customer c",
+        {
+            "SELECT c.c_name, c.c_acctbal FROM Customer c WHERE c.c_acctbal > 100"
+        },
+        false
+    });
+    
+    // Test Case 125: "!=" is not an equality; the view is refused
+    testcases.push_back({125, "View with a != selection",
+        "SELECT c.c_name FROM Customer c",
+        {
+            "SELECT c.c_name, c.c_nationkey FROM Customer c WHERE c.c_nationkey != 5"
+        },
+        false
+    });
+    
+    // Test Case 126: "<>" is not "<"; the view is refused, not widened
+    testcases.push_back({126, "View with a <> selection",
+        "SELECT c.c_name FROM Customer c",
+        {
+            "SELECT c.c_name, c.c_acctbal FROM Customer c WHERE c.c_acctbal <> 0"
+        },
+        false
+    });
+    
+    // Test Case 127: A query with an inequality is refused too
+    testcases.push_back({127, "Query with a != selection",
+        "SELECT c.c_name FROM Customer c WHERE c.c_nationkey != 5",
+        {
+            "SELECT c.c_name, c.c_nationkey FROM Customer c"
+        },
+        false
+    });
+    
     return testcases;
 }
 
@@ -1394,6 +1651,1201 @@ void writeTestCasesToFile(const std::vector<TestCase>& testcases, const std::str
     std::cout << "Test cases written to " << filename << "\n";
 }
 
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        ++failures;
+        std::cout << "FAIL: " << what << "\n";
+    }
+}
+
+// Parse a rule such as "V(x, w) :- R(x, y), S(y, 5)". Names starting with
+// a lower-case letter are variables, anything else a constant.
+ConjunctiveQuery datalog(const std::string& rule, std::shared_ptr<SymbolTable> symbols) {
+    auto parseAtom = [&](const std::string& text) {
+        size_t open = text.find('(');
+        Atom atom(symbols->intern(Utils::trim(text.substr(0, open))));
+        std::stringstream terms(text.substr(open + 1, text.rfind(')') - open - 1));
+        std::string term;
+        while (std::getline(terms, term, ',')) {
+            term = Utils::trim(term);
+            atom.addTerm(Term(symbols->intern(term), std::islower(term[0]) != 0));
+        }
+        return atom;
+    };
+    size_t arrow = rule.find(":-");
+    Atom head = parseAtom(rule.substr(0, arrow));
+    ConjunctiveQuery cq(symbols->name(head.relation));
+    cq.symbols = symbols;
+    cq.head = head.terms;
+    std::string body = rule.substr(arrow + 2);
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t close = body.find(')', start);
+        if (close == std::string::npos) break;
+        cq.body.push_back(parseAtom(body.substr(start, close + 1 - start)));
+        start = body.find_first_not_of(", ", close + 1);
+    }
+    return cq;
+}
+
+// Catalog holding `views`, converted with the catalog's own converter.
+// The converter's parse dumps on stderr are dropped.
+std::shared_ptr<ViewCatalog> catalogOf(const std::vector<std::string>& views) {
+    auto catalog = std::make_shared<ViewCatalog>();
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    for (size_t i = 0; i < views.size(); ++i) {
+        catalog->addView(views[i], "V" + std::to_string(i));
+    }
+    std::cerr.rdbuf(err);
+    return catalog;
+}
+
+ConjunctiveQuery convertQuery(const ViewCatalog& catalog, const std::string& sql) {
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    ConjunctiveQuery q = catalog.converter().convert(sql, "Q");
+    std::cerr.rdbuf(err);
+    return q;
+}
+
+// Rewrite every test case and compare with its expectation. Each
+// rewriting of a non-aggregate query must also be sound: its expansion
+// over the view definitions is contained in the query.
+void runTestCases(const std::vector<TestCase>& testcases) {
+    for (const auto& tc : testcases) {
+        auto catalog = catalogOf(tc.views);
+        MiniCon minicon(catalog);
+        minicon.verbose = false;
+        ConjunctiveQuery q = convertQuery(*catalog, tc.query);
+        minicon.setQuery(q);
+        auto rewritings = minicon.rewrite();
+        check(!rewritings.empty() == tc.should_have_rewriting,
+              "test case " + std::to_string(tc.id) + ": " + tc.description);
+        if (q.isAggregate()) continue;
+        for (const auto& rw : rewritings) {
+            check(isContainedIn(minicon.expandRewriting(rw), q),
+                  "test case " + std::to_string(tc.id) + ": unsound " + rw.toString(catalog->views));
+        }
+    }
+}
+
+// An MCD must try every view atom that can cover a forced subgoal: the
+// first S atom below sends z to an existential variable and fails.
+void testExtendMCDBacktracks() {
+    auto catalog = std::make_shared<ViewCatalog>();
+    catalog->addView(datalog("V(x, w) :- R(x, y), S(y, u), S(y, w)", catalog->symbols));
+    catalog->addView(datalog("W(z) :- T(z)", catalog->symbols));
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(datalog("Q(x) :- R(x, y), S(y, z), T(z)", catalog->symbols));
+    auto rewritings = minicon.rewrite();
+    check(rewritings.size() == 1, "extendMCD backtracks over candidate view atoms");
+}
+
+// Names intern to one ID each, and queries converted through the same
+// table share the IDs of their relations and variables
+void testSymbolTable() {
+    SymbolTable symbols;
+    int customer = symbols.intern("Customer");
+    check(symbols.intern("Customer") == customer, "interning a name twice gives one ID");
+    check(symbols.intern("Orders") != customer, "different names get different IDs");
+    check(symbols.lookup("Customer") == customer, "lookup finds an interned name");
+    check(symbols.lookup("Nation") == -1, "lookup of an unknown name is -1");
+    check(symbols.name(customer) == "Customer", "name() returns the interned string");
+    check(symbols.size() == 2, "size() counts distinct names");
+    
+    auto catalog = std::make_shared<ViewCatalog>();
+    ConjunctiveQuery q1 = convertQuery(*catalog, "SELECT c.c_name FROM Customer c");
+    ConjunctiveQuery q2 = convertQuery(*catalog, "SELECT c.c_name, c.c_phone FROM Customer c");
+    check(q1.body[0].relation == q2.body[0].relation, "one relation ID across queries");
+    check(q1.head[0] == q2.head[0], "one variable ID across queries");
+    check(q1.toString() == "Q(Customer_c_name) :- Customer(Customer_c_custkey, Customer_c_name, "
+                           "Customer_c_address, Customer_c_nationkey, Customer_c_phone, "
+                           "Customer_c_acctbal, Customer_c_mktsegment, Customer_c_comment)",
+          "queries print with names, not IDs");
+}
+
+// Coverage sets span more than one 64-bit word
+void testDynamicBitset() {
+    DynamicBitset a(130), b(130);
+    a.set(0);
+    a.set(64);
+    a.set(129);
+    b.set(65);
+    check(a.count() == 3 && a.test(64) && !a.test(63), "set/test across words");
+    check(!a.intersects(b), "disjoint sets do not intersect");
+    b.set(129);
+    check(a.intersects(b), "sets sharing bit 129 intersect");
+    check(a.findFirst() == 0 && a.findNext(0) == 64 && a.findNext(129) == -1,
+          "findNext walks the set bits");
+    std::vector<int> bits;
+    for (int i : a) bits.push_back(i);
+    check(bits == std::vector<int>({0, 64, 129}), "iteration yields the set bits in order");
+    
+    DynamicBitset c = a;
+    c.subtract(b);
+    check(c.count() == 2 && !c.test(129), "subtract clears the shared bit");
+    c |= b;
+    check(c.count() == 4, "union adds the other set");
+    DynamicBitset full(130);
+    full.setAll();
+    check(full.all() && full.count() == 130, "setAll sets exactly size() bits");
+    full.reset(100);
+    check(full.findFirstUnset() == 100, "findFirstUnset finds a cleared bit past word 1");
+    
+    // A query over 70 relations is rewritten with one view per subgoal
+    auto catalog = std::make_shared<ViewCatalog>();
+    std::string rule = "Q(x) :- ";
+    for (int i = 0; i < 70; ++i) {
+        std::string relation = "R" + std::to_string(i);
+        catalog->addView(datalog("V" + std::to_string(i) + "(x) :- " + relation + "(x)", 
+                                 catalog->symbols));
+        rule += (i > 0 ? ", " : "") + relation + "(x)";
+    }
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(datalog(rule, catalog->symbols));
+    auto rewritings = minicon.rewrite();
+    check(rewritings.size() == 1 && rewritings[0].view_indices.size() == 70 &&
+          rewritings[0].covered_subgoals.all(),
+          "query with more than 64 subgoals is fully covered");
+}
+
+// MCD formation starts from the view atoms over each subgoal's relation
+void testRelationIndex() {
+    auto catalog = catalogOf({
+        "SELECT o.o_orderkey, o.o_custkey FROM Orders o",
+        "SELECT c.c_custkey, c.c_name FROM Customer c",
+        "SELECT c.c_custkey, o.o_orderkey FROM Customer c, Orders o WHERE c.c_custkey = o.o_custkey",
+        "SELECT n.n_nationkey, n.n_name FROM Nation n"
+    });
+    int customer = catalog->symbols->lookup("Customer");
+    const auto& refs = catalog->atoms_by_relation[customer];
+    check(refs.size() == 2 && refs[0].view_index == 1 && refs[0].atom_index == 0 &&
+          refs[1].view_index == 2 && refs[1].atom_index == 0,
+          "relation index lists the Customer atoms in (view, atom) order");
+    
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(convertQuery(*catalog, "SELECT c.c_name FROM Customer c"));
+    check(minicon.candidateViews() == std::vector<int>({1, 2}),
+          "only views over the query's relations are candidates");
+    minicon.rewrite();
+    for (const auto& mcd : minicon.mcds) {
+        check(mcd.view_index == 1 || mcd.view_index == 2, "MCDs come from candidate views only");
+    }
+}
+
+// MCDs formed on a worker pool match the serial ones, in the same order
+void testParallelMCDs(const std::vector<TestCase>& testcases) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    for (const auto& tc : testcases) {
+        auto catalog = catalogOf(tc.views);
+        ConjunctiveQuery q = convertQuery(*catalog, tc.query);
+        MiniCon serial(catalog), parallel(catalog);
+        serial.verbose = parallel.verbose = false;
+        parallel.pool = pool;
+        serial.setQuery(q);
+        parallel.setQuery(q);
+        serial.findMCDs();
+        parallel.findMCDs();
+        bool same = serial.mcds.size() == parallel.mcds.size();
+        for (size_t i = 0; same && i < serial.mcds.size(); ++i) {
+            same = serial.mcds[i].view_index == parallel.mcds[i].view_index &&
+                   serial.mcds[i].covered_subgoals == parallel.mcds[i].covered_subgoals &&
+                   serial.mcds[i].variable_mapping.entries == parallel.mcds[i].variable_mapping.entries;
+        }
+        check(same, "test case " + std::to_string(tc.id) + ": parallel MCDs differ from serial");
+    }
+}
+
+// Every cover of the current query, in search order and unpruned
+std::vector<std::string> allCovers(MiniCon& minicon) {
+    minicon.prune_redundant = false;
+    minicon.findMCDs();
+    std::vector<QueryRewriting> rewritings;
+    minicon.generateRewritings(rewritings);
+    std::vector<std::string> covers;
+    for (const auto& rw : rewritings) covers.push_back(rw.toString(minicon.catalog->views));
+    return covers;
+}
+
+// Q(x) over four relations, with a view for every one and every pair of
+// them. Each subgoal has four MCDs (x is exported, so none is forced to
+// cover more), giving 256 covers: enough to split the search across
+// workers.
+std::shared_ptr<ViewCatalog> pairViewCatalog(ConjunctiveQuery& q) {
+    auto catalog = std::make_shared<ViewCatalog>();
+    std::vector<std::string> relations = {"A", "B", "C", "D"};
+    std::string rule = "Q(x) :- ";
+    for (size_t i = 0; i < relations.size(); ++i) {
+        rule += (i > 0 ? ", " : "") + relations[i] + "(x)";
+        catalog->addView(datalog("V" + relations[i] + "(x) :- " + relations[i] + "(x)", 
+                                 catalog->symbols));
+        for (size_t j = i + 1; j < relations.size(); ++j) {
+            catalog->addView(datalog("V" + relations[i] + relations[j] + "(x) :- " + 
+                                     relations[i] + "(x), " + relations[j] + "(x)", 
+                                     catalog->symbols));
+        }
+    }
+    q = datalog(rule, catalog->symbols);
+    return catalog;
+}
+
+// The work-stealing cover search returns the serial covers in serial order
+void testParallelCovers(const std::vector<TestCase>& testcases) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    auto compare = [&](std::shared_ptr<ViewCatalog> catalog, const ConjunctiveQuery& q,
+                       const std::string& what) {
+        MiniCon serial(catalog), parallel(catalog);
+        serial.verbose = parallel.verbose = false;
+        parallel.pool = pool;
+        serial.setQuery(q);
+        parallel.setQuery(q);
+        auto expected = allCovers(serial);
+        check(allCovers(parallel) == expected, what + ": parallel covers differ from serial");
+        return expected.size();
+    };
+    for (const auto& tc : testcases) {
+        auto catalog = catalogOf(tc.views);
+        compare(catalog, convertQuery(*catalog, tc.query), "test case " + std::to_string(tc.id));
+    }
+    ConjunctiveQuery q;
+    auto catalog = pairViewCatalog(q);
+    check(compare(catalog, q, "pair views") == 256, "pair views: 256 covers");
+}
+
+// The generator yields the covers one at a time in search order, and a
+// limited rewrite() returns the first ones without enumerating the rest
+void testRewritingGenerator() {
+    ConjunctiveQuery q;
+    auto catalog = pairViewCatalog(q);
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(q);
+    auto expected = allCovers(minicon);
+    
+    auto gen = minicon.generator();
+    QueryRewriting rewriting;
+    std::vector<std::string> streamed;
+    while (gen.next(rewriting)) streamed.push_back(rewriting.toString(catalog->views));
+    check(streamed == expected, "generator streams every cover in search order");
+    check(!gen.next(rewriting), "an exhausted generator stays exhausted");
+    
+    auto first = minicon.rewrite(5);
+    bool prefix = first.size() == 5;
+    for (size_t i = 0; prefix && i < first.size(); ++i) {
+        prefix = first[i].toString(catalog->views) == expected[i];
+    }
+    check(prefix, "rewrite(5) returns the first five covers");
+    
+    // With pruning on, every later cover is equivalent to the first
+    minicon.prune_redundant = true;
+    check(minicon.rewrite(5).size() == 1, "limited rewrite drops covers contained in earlier ones");
+}
+
+// rewrite() orders rewritings cheapest first, rewriteCheapest() finds the
+// cheapest by branch and bound, and repeated views get SQL aliases
+void testCostRanking() {
+    ConjunctiveQuery q;
+    auto catalog = pairViewCatalog(q);
+    for (size_t v = 0; v < catalog->views.size(); ++v) {
+        ViewStatistics stats;
+        stats.row_count = catalog->views[v].body.size() == 1 ? 5000 : 100 * (v + 1);
+        catalog->setViewStatistics(v, stats);
+    }
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.prune_redundant = false;
+    minicon.setQuery(q);
+    auto ranked = minicon.rewrite();
+    bool sorted = ranked.size() == 256;
+    for (size_t i = 1; sorted && i < ranked.size(); ++i) {
+        sorted = ranked[i - 1].cost <= ranked[i].cost;
+    }
+    check(sorted, "rewrite() ranks all covers by estimated cost");
+    QueryRewriting cheapest;
+    check(minicon.rewriteCheapest(cheapest) && cheapest.cost == ranked.front().cost,
+          "rewriteCheapest() finds the cost of the top-ranked rewriting");
+    
+    // rewriteCheapest() collapses repeated occurrences like rewrite(), but
+    // keeps a cheap rewriting that rewrite() prunes as contained in another
+    auto contained = std::make_shared<ViewCatalog>();
+    ViewStatistics small, large;
+    small.row_count = 10;
+    large.row_count = 1000;
+    contained->addView(datalog("V1(x) :- R(x, y), S(y)", contained->symbols), small);
+    contained->addView(datalog("V2(x, y) :- R(x, y)", contained->symbols), large);
+    MiniCon pruning(contained);
+    pruning.verbose = false;
+    pruning.minimize_query = false;
+    pruning.setQuery(datalog("Q(x) :- R(x, y), R(x, y)", contained->symbols));
+    auto kept = pruning.rewrite();
+    check(!kept.empty() && kept.front().view_indices == std::vector<int>({1}),
+          "rewrite() prunes the contained V1 and collapses the repeated V2");
+    check(pruning.rewriteCheapest(cheapest) && cheapest.view_indices == std::vector<int>({0}) &&
+          cheapest.cost == pruning.estimateCost(cheapest),
+          "rewriteCheapest() returns the contained V1 once, with its cost");
+    
+    // The paper query joins V3 with V2 twice
+    auto tpch = catalogOf({
+        "SELECT c.c_nationkey, c.c_name, n.n_name FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey",
+        "SELECT c.c_nationkey, c.c_name FROM Customer c",
+        "SELECT c.c_nationkey, c.c_name, s.s_name FROM Customer c, Supplier s WHERE c.c_nationkey = s.s_nationkey"
+    });
+    MiniCon paper(tpch);
+    paper.verbose = false;
+    ConjunctiveQuery query = convertQuery(*tpch, 
+        "SELECT c.c_name, s.s_name, n.n_name FROM Supplier s, Customer c, Nation n "
+        "WHERE c.c_nationkey = s.s_nationkey AND s.s_nationkey = n.n_nationkey AND n.n_nationkey = c.c_nationkey");
+    paper.setQuery(query);
+    auto rewritings = paper.rewrite();
+    std::string sql = rewritings.empty() ? "" : rewritings[0].toSQL(tpch->views, query);
+    check(sql.find("FROM V2, V0 AS V0_1, V0 AS V0_2 WHERE") != std::string::npos &&
+          sql.find("V0.") == std::string::npos,
+          "repeated views are aliased in SQL: " + sql);
+}
+
+// Queries equal up to variable names and atom order share a fingerprint
+// and a cache entry; a catalog change invalidates the entry
+void testRewritingCache() {
+    auto catalog = std::make_shared<ViewCatalog>();
+    catalog->addView(datalog("V1(a, b) :- R(a, b)", catalog->symbols));
+    catalog->addView(datalog("V2(b, c) :- S(b, c)", catalog->symbols));
+    ConjunctiveQuery q1 = datalog("Q(x, z) :- R(x, y), S(y, z)", catalog->symbols);
+    ConjunctiveQuery q2 = datalog("Q(u, w) :- S(v, w), R(u, v)", catalog->symbols);
+    ConjunctiveQuery q3 = datalog("Q(x, z) :- R(x, y), S(z, y)", catalog->symbols);
+    check(canonicalize(q1).fingerprint == canonicalize(q2).fingerprint,
+          "renamed and reordered queries share a fingerprint");
+    check(canonicalize(q1).fingerprint != canonicalize(q3).fingerprint,
+          "different joins have different fingerprints");
+    
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setCache(4);
+    minicon.setQuery(q1);
+    auto first = minicon.rewrite();
+    minicon.setQuery(q2);
+    auto cached = minicon.rewrite();
+    check(minicon.cache->hits == 1 && minicon.cache->misses == 1, "second query is a cache hit");
+    check(first.size() == 1 && cached.size() == 1 && 
+          isContainedIn(minicon.expandRewriting(cached[0]), q2),
+          "cached rewriting is translated to the second query's variables");
+    
+    catalog->addView(datalog("V3(a, c) :- R(a, b), S(b, c)", catalog->symbols));
+    auto fresh = minicon.rewrite();
+    check(minicon.cache->misses == 2, "catalog change misses the cache");
+    // V3 alone is equivalent to V1 joined with V2 and needs fewer views
+    check(fresh.size() == 1 && fresh[0].view_indices == std::vector<int>({2}),
+          "rewriting after the change uses the new view");
+    
+    // Settings that change the answer are part of the key
+    minicon.prune_redundant = false;
+    auto unpruned = minicon.rewrite();
+    check(minicon.cache->misses == 3 && unpruned.size() == 2, 
+          "turning pruning off misses the cache and keeps both rewritings");
+    minicon.prune_redundant = true;
+    check(minicon.rewrite().size() == 1 && minicon.cache->misses == 3,
+          "turning it back on hits the earlier entry");
+    minicon.cover_engine = MiniCon::CoverEngine::DancingLinks;
+    minicon.rewrite();
+    check(minicon.cache->misses == 4, "another cover engine misses the cache");
+    minicon.minimize_query = false;
+    minicon.setQuery(q1);
+    minicon.rewrite();
+    check(minicon.cache->misses == 5, "rewriting the query as written misses the cache");
+}
+
+// A rewriting whose expansion is contained in another's adds nothing to
+// the union and is pruned
+void testContainmentPruning(const std::vector<TestCase>& testcases) {
+    auto catalog = std::make_shared<ViewCatalog>();
+    catalog->addView(datalog("V1(a, b) :- R(a, b)", catalog->symbols));
+    catalog->addView(datalog("V2(b, c) :- S(b, c)", catalog->symbols));
+    catalog->addView(datalog("V3(a, b) :- R(a, b), T(a)", catalog->symbols));
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(datalog("Q(x, z) :- R(x, y), S(y, z)", catalog->symbols));
+    minicon.prune_redundant = false;
+    check(minicon.rewrite().size() == 2, "unpruned: V1 and V3 both cover R");
+    minicon.prune_redundant = true;
+    auto pruned = minicon.rewrite();
+    check(pruned.size() == 1 && pruned[0].view_indices == std::vector<int>({0, 1}),
+          "V3 join V2 is contained in V1 join V2 and pruned");
+    
+    // What survives on the TPC-H cases is pairwise non-redundant
+    for (const auto& tc : testcases) {
+        auto tpch = catalogOf(tc.views);
+        MiniCon mc(tpch);
+        mc.verbose = false;
+        ConjunctiveQuery q = convertQuery(*tpch, tc.query);
+        if (q.isAggregate()) continue;
+        mc.setQuery(q);
+        auto rewritings = mc.rewrite();
+        for (size_t i = 0; i < rewritings.size(); ++i) {
+            for (size_t j = 0; j < rewritings.size(); ++j) {
+                check(i == j || !isContainedIn(mc.expandRewriting(rewritings[i]), 
+                                               mc.expandRewriting(rewritings[j])),
+                      "test case " + std::to_string(tc.id) + ": rewriting " + 
+                      std::to_string(i) + " is redundant");
+            }
+        }
+    }
+}
+
+// minimizeQuery drops subgoals that fold onto others and keeps the rest
+void testQueryMinimization() {
+    auto symbols = std::make_shared<SymbolTable>();
+    ConjunctiveQuery redundant = datalog("Q(x) :- R(x, y), R(x, z), S(x)", symbols);
+    ConjunctiveQuery core = minimizeQuery(redundant);
+    check(core.body.size() == 2, "R(x, z) folds onto R(x, y)");
+    check(isContainedIn(core, redundant) && isContainedIn(redundant, core),
+          "the core is equivalent to the query");
+    
+    ConjunctiveQuery constant = minimizeQuery(datalog("Q(x) :- R(x, y), R(x, 5)", symbols));
+    check(constant.body.size() == 1 && !constant.body[0].terms[1].is_variable,
+          "R(x, y) folds onto R(x, 5), not the other way round");
+    
+    ConjunctiveQuery path = datalog("Q(x, z) :- R(x, y), R(y, z)", symbols);
+    check(minimizeQuery(path).body.size() == 2, "a path is its own core");
+    
+    auto catalog = std::make_shared<ViewCatalog>(symbols);
+    catalog->addView(datalog("V(a, b) :- R(a, b)", symbols));
+    catalog->addView(datalog("W(a) :- S(a)", symbols));
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(redundant);
+    check(minicon.query.body.size() == 2, "MiniCon rewrites the core");
+    auto rewritings = minicon.rewrite();
+    check(rewritings.size() == 1 && rewritings[0].view_indices.size() == 2,
+          "the core needs one V occurrence instead of two");
+}
+
+// Views come and go without rebuilding the catalog: IDs stay put, removed
+// views stop producing rewritings, and every change bumps the version
+void testViewCatalog() {
+    auto catalog = std::make_shared<ViewCatalog>();
+    int v1 = catalog->addView(datalog("V1(a, b) :- R(a, b)", catalog->symbols));
+    int v2 = catalog->addView(datalog("V2(a, b) :- S(a, b)", catalog->symbols));
+    uint64_t version = catalog->version;
+    
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(datalog("Q(x) :- R(x, y)", catalog->symbols));
+    check(minicon.rewrite().size() == 1, "V1 answers the query");
+    
+    check(catalog->removeView(v1) && !catalog->isLive(v1) && catalog->version == version + 1,
+          "removing a view tombstones it and bumps the version");
+    check(!catalog->removeView(v1), "a view is removed only once");
+    check(minicon.rewrite().empty(), "the removed view no longer rewrites the query");
+    
+    int v3 = catalog->addView(datalog("V3(a) :- R(a, b)", catalog->symbols));
+    check(v3 == 2 && catalog->isLive(v2) && catalog->views[v2].name == "V2",
+          "new views get fresh IDs and old IDs stay valid");
+    auto rewritings = minicon.rewrite();
+    check(rewritings.size() == 1 && rewritings[0].view_indices == std::vector<int>({v3}),
+          "the added view rewrites the query");
+    
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    auto other = std::make_shared<SymbolTable>();
+    check(catalog->addView(datalog("V4(a) :- R(a, b)", other)) == -1,
+          "views from another symbol table are refused");
+    std::cerr.rdbuf(err);
+    
+    // Queries can be converted while other threads rewrite and add views
+    auto tpch = catalogOf({"SELECT c.c_custkey, c.c_name FROM Customer c"});
+    std::vector<std::thread> threads;
+    std::atomic<int> answered{0};
+    err = std::cerr.rdbuf(nullptr);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            MiniCon mc(tpch);
+            mc.verbose = false;
+            for (int i = 0; i < 20; ++i) {
+                std::string sql = "SELECT c.c_name FROM Customer c WHERE c.c_custkey < " + 
+                                  std::to_string(t * 100 + i);
+                mc.setQuery(tpch->converter().convert(sql, "Q"));
+                if (t == 0 && i % 5 == 0) {
+                    tpch->addView("SELECT c.c_custkey, c.c_phone FROM Customer c",
+                                  "P" + std::to_string(i));
+                }
+                if (!mc.rewrite().empty()) ++answered;
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::cerr.rdbuf(err);
+    check(answered == 80, "concurrent conversion, rewriting and addView");
+    check(tpch->symbols->lookup("Customer_c_name") != -1 && 
+          tpch->symbols->name(tpch->symbols->lookup("Customer_c_name")) == "Customer_c_name",
+          "names interned concurrently resolve back to themselves");
+}
+
+// A batch gives every query the rewritings it gets on its own
+void testRewriteBatch(const std::vector<TestCase>& testcases) {
+    std::vector<std::string> views;
+    std::vector<std::string> sqls;
+    for (const auto& tc : testcases) {
+        if (tc.id > 8) break;
+        views.insert(views.end(), tc.views.begin(), tc.views.end());
+        sqls.push_back(tc.query);
+    }
+    auto catalog = catalogOf(views);
+    std::vector<ConjunctiveQuery> queries;
+    for (const auto& sql : sqls) queries.push_back(convertQuery(*catalog, sql));
+    // Repeats share every subgoal with an earlier query
+    queries.push_back(queries[0]);
+    queries.push_back(queries[4]);
+    
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    auto batch = minicon.rewriteBatch(queries);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        minicon.setQuery(queries[i]);
+        auto single = minicon.rewrite();
+        bool same = single.size() == batch[i].size();
+        for (size_t k = 0; same && k < single.size(); ++k) {
+            same = single[k].toString(catalog->views) == batch[i][k].toString(catalog->views);
+        }
+        check(same, "batch query " + std::to_string(i) + " differs from its own rewrite()");
+    }
+    
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    auto other = std::make_shared<SymbolTable>();
+    auto mixed = minicon.rewriteBatch({datalog("Q(x) :- R(x, y)", other), queries[0]});
+    std::cerr.rdbuf(err);
+    check(mixed[0].empty() && mixed[1].size() == batch[0].size(),
+          "a query from another symbol table gets no rewritings");
+    
+    // An outer-join query between two others must not answer with the
+    // rewritings of the query before it
+    ConjunctiveQuery outer = convertQuery(*catalog, 
+        "SELECT c.c_name, o.o_orderkey FROM Customer c LEFT OUTER JOIN Orders o ON c.c_custkey = o.o_custkey");
+    check(outer.hasOuterJoin(), "the outer-join query keeps its outer join");
+    err = std::cerr.rdbuf(nullptr);
+    check(!minicon.setQuery(outer), "setQuery rejects an outer-join query");
+    auto around = minicon.rewriteBatch({queries[0], outer, queries[4]});
+    std::cerr.rdbuf(err);
+    check(!batch[0].empty() && around[0].size() == batch[0].size() && 
+          around[1].empty() && around[2].size() == batch[4].size(),
+          "an outer-join query in a batch gets no rewritings");
+}
+
+// The compatibility bitmatrix is symmetric and agrees with the pairwise
+// test, whether rows are filled serially or on a pool
+void testCompatibilityMatrix(const std::vector<TestCase>& testcases) {
+    auto pool = std::make_shared<ThreadPool>(4);
+    for (const auto& tc : testcases) {
+        auto catalog = catalogOf(tc.views);
+        MiniCon minicon(catalog);
+        minicon.verbose = false;
+        minicon.setQuery(convertQuery(*catalog, tc.query));
+        minicon.findMCDs();
+        auto serial = minicon.buildCoverIndex();
+        minicon.pool = pool;
+        auto parallel = minicon.buildCoverIndex();
+        if (!serial->coverable) continue;
+        bool ok = serial->compatible == parallel->compatible;
+        const auto& mcds = minicon.mcds;
+        for (size_t i = 0; ok && i < mcds.size(); ++i) {
+            for (size_t j = 0; ok && j < mcds.size(); ++j) {
+                bool expected = i != j &&
+                    !mcds[i].covered_subgoals.intersects(mcds[j].covered_subgoals) &&
+                    minicon.isConsistentMapping(mcds[i].variable_mapping, mcds[j].variable_mapping);
+                ok = serial->compatible[i].test(j) == expected &&
+                     serial->compatible[i].test(j) == serial->compatible[j].test(i);
+            }
+        }
+        check(ok, "test case " + std::to_string(tc.id) + ": compatibility matrix");
+    }
+}
+
+// Dancing Links finds the covers the backtracking search finds, in the
+// same order
+void testDancingLinks(const std::vector<TestCase>& testcases) {
+    // Knuth's example matrix has the single exact cover {0, 3, 4}
+    std::vector<std::vector<int>> rows = {
+        {2, 4, 5}, {0, 3, 6}, {1, 2, 5}, {0, 3}, {1, 6}, {3, 4, 6}
+    };
+    std::vector<DynamicBitset> all(rows.size(), DynamicBitset(rows.size()));
+    for (auto& row : all) row.setAll();
+    std::vector<std::vector<int>> found;
+    DancingLinks(7, rows, all).search([&](const std::vector<int>& cover) {
+        std::vector<int> sorted = cover;
+        std::sort(sorted.begin(), sorted.end());
+        found.push_back(sorted);
+    });
+    check(found == std::vector<std::vector<int>>({{0, 3, 4}}), "Knuth's exact cover example");
+    // Declaring rows 0 and 3 incompatible rules that cover out
+    all[0].reset(3);
+    all[3].reset(0);
+    found.clear();
+    DancingLinks(7, rows, all).search([&](const std::vector<int>& cover) { found.push_back(cover); });
+    check(found.empty(), "incompatible rows never share a cover");
+    
+    auto compare = [](std::shared_ptr<ViewCatalog> catalog, const ConjunctiveQuery& q,
+                      const std::string& what) {
+        MiniCon backtracking(catalog), dlx(catalog);
+        backtracking.verbose = dlx.verbose = false;
+        dlx.cover_engine = MiniCon::CoverEngine::DancingLinks;
+        backtracking.setQuery(q);
+        dlx.setQuery(q);
+        auto expected = allCovers(backtracking);
+        check(allCovers(dlx) == expected, what + ": Dancing Links covers differ");
+        return expected.size();
+    };
+    for (const auto& tc : testcases) {
+        auto catalog = catalogOf(tc.views);
+        compare(catalog, convertQuery(*catalog, tc.query), "test case " + std::to_string(tc.id));
+    }
+    ConjunctiveQuery q;
+    auto catalog = pairViewCatalog(q);
+    check(compare(catalog, q, "pair views") == 256, "Dancing Links: 256 pair-view covers");
+}
+
+// The interval index returns exactly the intervals that overlap a probe
+void testIntervalIndex() {
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> value(0, 1000);
+    std::bernoulli_distribution coin(0.3);
+    auto randomInterval = [&]() {
+        Interval i;
+        int a = value(rng), b = value(rng);
+        if (!coin(rng)) i.lo = std::min(a, b);
+        if (!coin(rng)) i.hi = std::max(a, b);
+        i.lo_strict = coin(rng);
+        i.hi_strict = coin(rng);
+        return i;
+    };
+    std::vector<std::pair<Interval, ViewAtomRef>> items;
+    for (int v = 0; v < 500; ++v) items.push_back({randomInterval(), ViewAtomRef{v, 0}});
+    IntervalIndex index;
+    index.build(items);
+    
+    bool ok = true;
+    for (int probe = 0; probe < 200 && ok; ++probe) {
+        Interval range = randomInterval();
+        std::vector<ViewAtomRef> found;
+        index.overlapping(range, found);
+        std::vector<int> found_views, expected_views;
+        for (const auto& ref : found) found_views.push_back(ref.view_index);
+        for (const auto& [interval, ref] : items) {
+            Interval overlap = interval;
+            overlap.intersect(range);
+            if (!overlap.empty()) expected_views.push_back(ref.view_index);
+        }
+        std::sort(found_views.begin(), found_views.end());
+        ok = found_views == expected_views;
+    }
+    check(ok, "interval index agrees with a linear scan");
+    
+    // Views whose range misses the query's are not even candidates
+    auto catalog = catalogOf({
+        "SELECT c.c_name, c.c_acctbal FROM Customer c WHERE c.c_acctbal < 2500",
+        "SELECT c.c_name, c.c_acctbal FROM Customer c WHERE c.c_acctbal > 5000",
+        "SELECT c.c_name, c.c_acctbal FROM Customer c"
+    });
+    MiniCon minicon(catalog);
+    minicon.verbose = false;
+    minicon.setQuery(convertQuery(*catalog, "SELECT c.c_name FROM Customer c WHERE c.c_acctbal < 1000"));
+    auto rewritings = minicon.rewrite();
+    check(minicon.candidateViews() == std::vector<int>({0, 2}), "range index filters candidate views");
+    // Once filtered to the query range the two views give the same answer
+    check(rewritings.size() == 1, "equivalent rewritings of the remaining views are pruned");
+}
+
+// Small TPC-H tables with values drawn from narrow domains, so joins
+// match often and outer joins leave rows unmatched
+std::shared_ptr<const Table> randomTable(const std::string& relation, size_t rows, 
+                                         std::mt19937& rng) {
+    auto table = std::make_shared<Table>();
+    for (const auto& spec : TableLoader::tpchSchema(relation)) {
+        ColumnBuilder builder(spec.type);
+        // Nation keys stop short of the other tables' nation keys
+        int keys = spec.name == "n_nationkey" ? 6 : 10;
+        for (size_t r = 0; r < rows; ++r) {
+            switch (spec.type) {
+                case ColumnType::Int64: builder.appendInt(rng() % keys); break;
+                case ColumnType::Double: builder.appendDouble(double(rng() % 5000)); break;
+                case ColumnType::String: builder.appendString("s" + std::to_string(rng() % 4)); break;
+            }
+        }
+        table->addColumn(spec.name, builder.finish());
+    }
+    return table;
+}
+
+void addRandomTPCH(ColumnarExecutor& executor, size_t rows, unsigned seed) {
+    std::mt19937 rng(seed);
+    for (const char* relation : {"customer", "orders", "lineitem", "part", 
+                                 "supplier", "partsupp", "nation", "region"}) {
+        executor.addTable(relation, randomTable(relation, rows, rng));
+    }
+}
+
+// The rows of a table as text, in table order
+std::vector<std::string> orderedRows(const Table& table) {
+    std::vector<std::string> rows;
+    for (size_t r = 0; r < table.rows(); ++r) {
+        std::string row;
+        for (const auto& column : table.columns) row += column.toString(r) + "|";
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+// The same sorted; `distinct` drops repeats
+std::vector<std::string> rowsOf(const Table& table, bool distinct = false) {
+    std::vector<std::string> rows = orderedRows(table);
+    std::sort(rows.begin(), rows.end());
+    if (distinct) rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+// Every rewriting that is equivalent to its query returns the query's
+// answer when run over the materialized views: the same rows for a plain
+// query (view joins may repeat rows, so as sets), the same groups and
+// values for an aggregate one
+void testExecuteRewritings(const std::vector<TestCase>& testcases) {
+    ColumnarExecutor executor;
+    addRandomTPCH(executor, 20, 7);
+    size_t compared = 0;
+    for (const auto& tc : testcases) {
+        if (!tc.should_have_rewriting) continue;
+        auto catalog = catalogOf(tc.views);
+        ColumnarExecutor run = executor;
+        for (const auto& view : catalog->views) run.materialize(view);
+        MiniCon minicon(catalog);
+        minicon.verbose = false;
+        ConjunctiveQuery q = convertQuery(*catalog, tc.query);
+        minicon.setQuery(q);
+        std::vector<std::string> expected = rowsOf(run.execute(q), !q.isAggregate());
+        for (const auto& rw : minicon.rewrite()) {
+            if (!q.isAggregate() && !isContainedIn(q, minicon.expandRewriting(rw))) continue;
+            check(rowsOf(run.execute(rw, catalog->views, q), !q.isAggregate()) == expected,
+                  "test case " + std::to_string(tc.id) + ": rewriting " + 
+                  rw.toString(catalog->views) + " returns other rows than the query");
+            ++compared;
+        }
+    }
+    check(compared > 100, "most test cases have an equivalent rewriting to run");
+    
+    // The outer-join cases above do read padded rows
+    auto catalog = catalogOf({"SELECT c.c_name, s.s_name FROM Customer c LEFT OUTER JOIN Supplier s "
+                              "ON c.c_nationkey = s.s_nationkey AND c.c_acctbal < 1000"});
+    auto view = executor.materialize(catalog->views[0]);
+    bool padded = false;
+    for (size_t r = 0; r < view->rows(); ++r) padded |= view->columns[1].isNull(r);
+    check(padded, "left outer join view pads unmatched customers with NULLs");
+}
+
+// The batched hash join finds exactly the pairs a nested loop does: NULL
+// keys never match, Int64 and Double keys compare by value, and several
+// keys must all match
+void testHashJoin() {
+    std::mt19937 rng(21);
+    auto numbers = [&](ColumnType type, size_t n, int domain) {
+        ColumnBuilder builder(type);
+        for (size_t i = 0; i < n; ++i) {
+            int value = rng() % domain;
+            if (rng() % 10 == 0) builder.appendNull();
+            else if (type == ColumnType::Int64) builder.appendInt(value);
+            else builder.appendDouble(value == 0 && rng() % 2 ? -0.0 : value);
+        }
+        return builder.finish();
+    };
+    auto strings = [&](size_t n, int domain) {
+        ColumnBuilder builder(ColumnType::String);
+        for (size_t i = 0; i < n; ++i) builder.appendString("k" + std::to_string(rng() % domain));
+        return builder.finish();
+    };
+    auto identity = [](size_t n) {
+        std::vector<uint32_t> rows(n);
+        for (size_t i = 0; i < n; ++i) rows[i] = i;
+        return rows;
+    };
+    auto compare = [&](const std::vector<Column>& build, const std::vector<Column>& probe,
+                       const std::string& what) {
+        size_t n_build = build.empty() ? 40 : build[0].length;
+        size_t n_probe = probe.empty() ? 30 : probe[0].length;
+        std::vector<uint32_t> build_rows = identity(n_build), probe_rows = identity(n_probe);
+        std::vector<HashJoin::Key> build_keys, probe_keys;
+        for (const auto& c : build) build_keys.push_back({&c, build_rows.data()});
+        for (const auto& c : probe) probe_keys.push_back({&c, probe_rows.data()});
+        auto matches = HashJoin::join(build_keys, n_build, probe_keys, n_probe);
+        std::vector<std::pair<uint32_t, uint32_t>> found, expected;
+        for (size_t m = 0; m < matches.probe.size(); ++m) {
+            found.push_back({matches.probe[m], matches.build[m]});
+        }
+        for (uint32_t p = 0; p < n_probe; ++p) {
+            for (uint32_t b = 0; b < n_build; ++b) {
+                bool equal = true;
+                for (size_t k = 0; k < build.size() && equal; ++k) {
+                    equal = !build[k].isNull(b) && !probe[k].isNull(p) &&
+                            (build[k].numeric() 
+                                 ? build[k].numberAt(b) == probe[k].numberAt(p)
+                                 : build[k].stringAt(b) == probe[k].stringAt(p));
+                }
+                if (equal) expected.push_back({p, b});
+            }
+        }
+        std::sort(found.begin(), found.end());
+        check(found == expected, what);
+    };
+    // Sizes past one batch on both sides
+    compare({numbers(ColumnType::Int64, 3000, 500)}, {numbers(ColumnType::Int64, 2500, 500)},
+            "hash join on Int64 keys with NULLs");
+    compare({numbers(ColumnType::Int64, 1500, 50)}, {numbers(ColumnType::Double, 1200, 50)},
+            "hash join of Int64 with Double keys");
+    compare({numbers(ColumnType::Double, 800, 30), strings(800, 5)},
+            {numbers(ColumnType::Double, 900, 30), strings(900, 5)},
+            "hash join on a Double and a String key");
+    compare({}, {}, "hash join without keys is a cross product");
+}
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("minicon_test_" + name)).string();
+}
+
+// A dbgen file large enough to be split into several chunks loads the
+// same rows in the same order whatever the thread count; CSV files may
+// quote fields, start with a header and end lines with CRLF
+void testTableLoader() {
+    std::mt19937 rng(22);
+    auto customer = randomTable("customer", 200000, rng);
+    std::string tbl = tempPath("customer.tbl");
+    {
+        std::ofstream out(tbl);
+        for (const auto& row : orderedRows(*customer)) out << row << "\n";
+    }
+    check(std::filesystem::file_size(tbl) > 4 << 20, "dbgen file spans several chunks");
+    for (unsigned threads : {1u, 8u, 13u}) {
+        TableLoader loader(threads);
+        auto loaded = loader.load(tbl, TableLoader::tpchSchema("customer"));
+        check(loaded && loaded->names == customer->names && 
+              orderedRows(*loaded) == orderedRows(*customer),
+              "dbgen round trip with " + std::to_string(threads) + " threads");
+    }
+    std::filesystem::remove(tbl);
+    
+    std::string csv = tempPath("nation.csv");
+    {
+        std::ofstream out(csv, std::ios::binary);
+        out << "n_nationkey,n_name,n_regionkey,n_comment\r\n"
+            << "0,ALGERIA,0,\"plain, with a comma\"\r\n"
+            << "1,\"ARGENTINA\",,\"says \"\"hi\"\"\"\r\n"
+            << "\r\n"
+            << "x,BRAZIL,1,bad key\n"
+            << "3,CANADA,1\n";
+    }
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    auto nation = TableLoader(2).load(csv, TableLoader::tpchSchema("nation"));
+    std::cerr.rdbuf(err);
+    std::filesystem::remove(csv);
+    check(nation && orderedRows(*nation) == std::vector<std::string>({
+              "0|ALGERIA|0|plain, with a comma|",
+              "1|ARGENTINA|NULL|says \"hi\"|",
+              "NULL|BRAZIL|1|bad key|",
+              "3|CANADA|1|NULL|"}),
+          "CSV header, quotes, blank lines, bad and missing fields");
+    
+    // A dbgen file has no header, so a first row that does not parse stays
+    std::string region = tempPath("region.tbl");
+    {
+        std::ofstream out(region);
+        out << "x|AFRICA|first|\n1|AMERICA|second|\n";
+    }
+    err = std::cerr.rdbuf(nullptr);
+    auto regions = TableLoader(2).load(region, TableLoader::tpchSchema("region"));
+    std::cerr.rdbuf(err);
+    std::filesystem::remove(region);
+    check(regions && orderedRows(*regions) == std::vector<std::string>({
+              "NULL|AFRICA|first|", "1|AMERICA|second|"}),
+          "dbgen first row that does not parse is kept");
+}
+
+// Overwrite `bytes` of the file at `path` starting at `offset` (from the
+// end when negative)
+void patchFile(const std::string& path, long offset, const std::string& bytes) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+    file.write(bytes.data(), bytes.size());
+}
+
+// Tables survive a write and a mapped read unchanged, and damaged files
+// are refused instead of read out of bounds
+void testColumnarFile() {
+    std::mt19937 rng(23);
+    auto table = std::make_shared<Table>();
+    ColumnBuilder names(ColumnType::String), keys(ColumnType::Int64), prices(ColumnType::Double);
+    for (int r = 0; r < 5000; ++r) {
+        if (r % 7 == 0) names.appendNull(); else names.appendString("name" + std::to_string(rng() % 50));
+        keys.appendInt(int64_t(rng()) - (1LL << 31));
+        if (r % 11 == 0) prices.appendNull(); else prices.appendDouble((rng() % 100000) / 8.0);
+    }
+    table->addColumn("name", names.finish());
+    table->addColumn("key", keys.finish());
+    table->addColumn("price", prices.finish());
+    
+    std::string path = tempPath("view.col");
+    check(ColumnarFile::write(*table, path), "columnar file is written");
+    auto read = ColumnarFile::read(path);
+    check(read && read->names == table->names && orderedRows(*read) == orderedRows(*table),
+          "columnar file round trip keeps names, values and NULLs");
+    
+    Table empty;
+    empty.addColumn("key", ColumnBuilder(ColumnType::Int64).finish());
+    std::string empty_path = tempPath("empty.col");
+    ColumnarFile::write(empty, empty_path);
+    auto empty_read = ColumnarFile::read(empty_path);
+    check(empty_read && empty_read->rows() == 0 && empty_read->names == empty.names,
+          "an empty table round trips");
+    std::filesystem::remove(empty_path);
+    
+    // Each damaged copy must be refused
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    auto damaged = [&](const std::function<void(const std::string&)>& damage) {
+        std::string copy = tempPath("damaged.col");
+        std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+        damage(copy);
+        bool refused = ColumnarFile::read(copy) == nullptr;
+        std::filesystem::remove(copy);
+        return refused;
+    };
+    bool all_refused = 
+        damaged([](const std::string& p) { patchFile(p, 0, "XCCOLUMN"); }) &&
+        damaged([](const std::string& p) { patchFile(p, -8, "MCCOLUMX"); }) &&
+        damaged([](const std::string& p) { 
+            std::filesystem::resize_file(p, std::filesystem::file_size(p) - 24); }) &&
+        damaged([](const std::string& p) { patchFile(p, -16, std::string("\x01\0\0\0\0\0\0\x7f", 8)); }) &&
+        // The name column's codes start right after the magic
+        damaged([](const std::string& p) { patchFile(p, 8, "\xff\xff\xff\xff"); });
+    std::cerr.rdbuf(err);
+    check(all_refused, "damaged columnar files are refused");
+    check(ColumnarFile::read(path) != nullptr, "the original file still reads");
+    std::filesystem::remove(path);
+    
+    // Views persisted through the catalog reopen in a fresh executor
+    ColumnarExecutor executor;
+    addRandomTPCH(executor, 50, 23);
+    auto catalog = catalogOf({"SELECT c.c_custkey, c.c_name, c.c_nationkey FROM Customer c"});
+    std::string view_path = tempPath("V0.col");
+    auto rows = executor.materialize(catalog->views[0]);
+    check(ColumnarFile::persistView(*catalog, 0, *rows, view_path), "view is persisted");
+    ColumnarExecutor reopened;
+    check(ColumnarFile::openViews(*catalog, reopened) == 1 &&
+          orderedRows(*reopened.table("V0")) == orderedRows(*rows),
+          "persisted view reopens with the same rows");
+    std::filesystem::remove(view_path);
+}
+
+// The given rows, each a table and a row of it, all tables alike
+Table pickRows(const std::vector<std::pair<const Table*, size_t>>& rows) {
+    Table picked;
+    const Table& shape = *rows.front().first;
+    for (size_t c = 0; c < shape.columns.size(); ++c) {
+        ColumnBuilder builder(shape.columns[c].type);
+        for (const auto& [table, r] : rows) builder.appendFrom(table->columns[c], r);
+        picked.addColumn(shape.names[c], builder.finish());
+    }
+    return picked;
+}
+
+// After applyDelta every materialized view holds what materializing it
+// from the changed tables gives, for self-joins, repeated and missing
+// deletions, aggregate and outer-join views alike
+void testIncrementalMaintenance() {
+    ColumnarExecutor executor;
+    addRandomTPCH(executor, 30, 24);
+    auto catalog = catalogOf({
+        "SELECT c.c_name, n.n_name FROM Customer c, Nation n WHERE c.c_nationkey = n.n_nationkey",
+        "SELECT c.c_name, o.o_orderkey FROM Customer c, Orders o WHERE c.c_custkey = o.o_custkey AND c.c_acctbal < 2500",
+        "SELECT c.c_nationkey, COUNT(*) AS cnt, SUM(c.c_acctbal) AS total FROM Customer c GROUP BY c.c_nationkey",
+        "SELECT c.c_name, s.s_name FROM Customer c LEFT OUTER JOIN Supplier s ON c.c_nationkey = s.s_nationkey"
+    });
+    // Customers of the same nation, a view over two Customer atoms
+    catalog->addView(datalog("Pairs(n1, n2) :- Customer(k1, n1, a1, nk, p1, b1, m1, c1), "
+                             "Customer(k2, n2, a2, nk, p2, b2, m2, c2)", catalog->symbols));
+    check(catalog->views.size() == 5, "all five views are in the catalog");
+    for (const auto& view : catalog->views) executor.materialize(view);
+    
+    std::mt19937 rng(240);
+    size_t initial_rows = executor.table("customer")->rows();
+    for (int round = 0; round < 4; ++round) {
+        std::string label = " (round " + std::to_string(round) + ")";
+        // Round 2 holds on to the table while it changes
+        auto current = executor.table("customer");
+        std::vector<std::string> before = orderedRows(*current);
+        auto fresh = randomTable("customer", 5, rng);
+        // Delete one row twice, two others once, and a row the table
+        // never held
+        Table deleted = pickRows({{current.get(), 3}, {current.get(), 3}, {current.get(), 10},
+                                  {current.get(), current->rows() - 1}, {fresh.get(), 4}});
+        // Inserting a row twice leaves the next round a duplicate to delete
+        Table inserted = pickRows({{fresh.get(), 0}, {fresh.get(), 1}, {fresh.get(), 2}, 
+                                   {fresh.get(), 2}});
+        const Table* customer_table = current.get();
+        const Table* pairs_table = executor.table("Pairs").get();
+        if (round != 2) current = nullptr;
+        check(executor.applyDelta("customer", inserted, deleted, catalog->views),
+              "delta fits the customer table" + label);
+        
+        if (round == 1 || round == 3) {
+            check(executor.table("customer").get() == customer_table &&
+                  executor.table("Pairs").get() == pairs_table, 
+                  "an unshared table and view change in place" + label);
+        }
+        if (round == 2) {
+            check(executor.table("customer") != current && orderedRows(*current) == before,
+                  "a table someone holds is left as it was" + label);
+        }
+        std::vector<std::string> expected = before;
+        for (const auto& row : orderedRows(deleted)) {
+            auto it = std::find(expected.begin(), expected.end(), row);
+            if (it != expected.end()) expected.erase(it);
+        }
+        for (const auto& row : orderedRows(inserted)) expected.push_back(row);
+        std::sort(expected.begin(), expected.end());
+        check(rowsOf(*executor.table("customer")) == expected,
+              "base table loses one occurrence per deleted row and gains the inserted ones" + label);
+        for (const auto& view : catalog->views) {
+            check(rowsOf(*executor.table(view.name)) == rowsOf(executor.execute(view)),
+                  "view " + view.name + " differs from its recomputation" + label);
+        }
+    }
+    check(executor.table("customer")->rows() != initial_rows, "the deltas changed the table");
+    check(executor.table("Pairs")->rows() > executor.table("customer")->rows(), 
+          "the self-join pairs customers of a nation");
+    
+    std::streambuf* err = std::cerr.rdbuf(nullptr);
+    bool refused = !executor.applyDelta("customer", *executor.table("nation"), Table(), catalog->views);
+    std::cerr.rdbuf(err);
+    check(refused, "rows of another shape are refused");
+}
+
+bool near(double estimate, double exact, double relative) {
+    return std::abs(estimate - exact) <= relative * exact;
+}
+
+// HyperLogLog estimates stay within a few standard errors (0.8%) of the
+// true count on a fixed seed, and a merged sketch is the sketch of the
+// union
+void testHyperLogLog() {
+    std::mt19937_64 rng(25);
+    std::vector<uint64_t> hashes(100000);
+    for (auto& h : hashes) h = rng();
+    
+    HyperLogLog all, first, second;
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        all.add(hashes[i]);
+        // The halves overlap by a fifth of the values
+        if (i < 60000) first.add(hashes[i]);
+        if (i >= 40000) second.add(hashes[i]);
+    }
+    check(near(all.estimate(), 100000, 0.03), "HyperLogLog estimate of 100000 distinct values");
+    check(near(first.estimate(), 60000, 0.03), "HyperLogLog estimate of 60000 distinct values");
+    for (size_t i = 0; i < 1000; ++i) all.add(hashes[i]);
+    check(near(all.estimate(), 100000, 0.03), "repeated values leave the estimate alone");
+    first.merge(second);
+    check(first.estimate() == all.estimate(), "merged sketch equals the sketch of the union");
+    
+    HyperLogLog small;
+    for (size_t i = 0; i < 1000; ++i) small.add(hashes[i]);
+    check(near(small.estimate(), 1000, 0.02), "linear counting of 1000 distinct values");
+    check(HyperLogLog().estimate() == 0, "empty sketch estimates zero");
+}
+
+// Statistics of a table spanning several chunks: exact counts and
+// ranges, distinct counts within the sketch's error, and a histogram
+// whose buckets estimate range fractions close to the true ones, however
+// many threads collect them
+void testStatisticsBuilder() {
+    const size_t n_rows = 300000;
+    std::mt19937 rng(250);
+    ColumnBuilder ints(ColumnType::Int64), doubles(ColumnType::Double), strings(ColumnType::String);
+    size_t int_nulls = 0, low_ints = 0, string_bytes = 0;
+    double min_double = 1e9, max_double = -1e9;
+    for (size_t r = 0; r < n_rows; ++r) {
+        if (rng() % 10 == 0) {
+            ints.appendNull();
+            ++int_nulls;
+        } else {
+            int64_t value = rng() % 10000;
+            ints.appendInt(value);
+            low_ints += value < 2500;
+        }
+        // Skewed towards zero
+        double value = std::pow(double(rng() % 1000), 2) / 100 - 50;
+        doubles.appendDouble(value);
+        min_double = std::min(min_double, value);
+        max_double = std::max(max_double, value);
+        std::string text = "name" + std::to_string(rng() % 500);
+        strings.appendString(text);
+        string_bytes += text.size();
+    }
+    Table table;
+    table.addColumn("i", ints.finish());
+    table.addColumn("d", doubles.finish());
+    table.addColumn("s", strings.finish());
+    
+    for (unsigned threads : {1u, 8u}) {
+        std::string label = " (" + std::to_string(threads) + " threads)";
+        auto stats = StatisticsBuilder(threads).build(table);
+        check(stats.size() == 3, "one entry per column" + label);
+        const ColumnStatistics& i = stats[0], & d = stats[1], & s = stats[2];
+        
+        check(i.rows == n_rows && i.nulls == int_nulls, "row and NULL counts" + label);
+        check(i.has_range && i.min == 0 && i.max == 9999, "integer range" + label);
+        check(near(i.distinct, 10000, 0.03), "integer distinct count" + label);
+        check(i.bounds.size() == StatisticsBuilder::HISTOGRAM_BUCKETS + 1 &&
+              std::is_sorted(i.bounds.begin(), i.bounds.end()) &&
+              i.bounds.front() == i.min && i.bounds.back() == i.max, 
+              "histogram bounds run from min to max" + label);
+        Interval everything;
+        check(near(i.fractionIn(everything), double(n_rows - int_nulls) / n_rows, 1e-9),
+              "the whole range holds every non-NULL row" + label);
+        Interval low, high;
+        low.hi = 2500;
+        low.hi_strict = true;
+        high.lo = 2500;
+        check(std::abs(i.fractionIn(low) - double(low_ints) / n_rows) < 0.02, 
+              "fraction below 2500" + label);
+        check(near(i.fractionIn(low) + i.fractionIn(high), i.fractionIn(everything), 1e-9),
+              "fractions of a split range add up" + label);
+        
+        check(d.nulls == 0 && d.min == min_double && d.max == max_double, "double range" + label);
+        // Equi-depth: the skew shows in narrow low buckets
+        check(d.bounds[1] - d.bounds[0] < d.bounds.back() - d.bounds[d.bounds.size() - 2],
+              "skewed values give narrow buckets where they crowd" + label);
+        Interval below;
+        below.hi = 2450;        // (500^2) / 100 - 50: half of the draws
+        check(std::abs(d.fractionIn(below) - 0.5) < 0.03, "fraction of skewed doubles" + label);
+        
+        check(!s.has_range && s.bounds.empty(), "strings have no histogram" + label);
+        check(near(s.distinct, 500, 0.03), "string distinct count" + label);
+        check(near(s.width, double(string_bytes) / n_rows, 1e-9), "string width" + label);
+    }
+    
+    Table empty;
+    empty.addColumn("i", ColumnBuilder(ColumnType::Int64).finish());
+    auto stats = StatisticsBuilder(2).build(empty);
+    check(stats.size() == 1 && stats[0].rows == 0 && stats[0].distinct == 0 && 
+          !stats[0].has_range, "empty column");
+}
+
+// "!=" and "<>" are refused rather than read as "=" or "<" or dropped
+void testInequalities() {
+    ViewCatalog catalog;
+    for (const char* sql : {"SELECT c.c_name FROM Customer c WHERE c.c_nationkey != 5",
+                            "SELECT c.c_name FROM Customer c WHERE c.c_acctbal <> 0",
+                            "SELECT c.c_name FROM Customer c WHERE c.c_acctbal > 0 AND c.c_nationkey <> 5"}) {
+        check(convertQuery(catalog, sql).body.empty(), std::string("inequality refused: ") + sql);
+    }
+    ConjunctiveQuery ranged = convertQuery(catalog, "SELECT c.c_name FROM Customer c WHERE c.c_acctbal <= 10");
+    check(!ranged.body.empty() && ranged.intervals().size() == 1, "\"<=\" is still a range");
+}
+
 int main() {
     std::vector<TestCase> testcases = generateTestCases();
     
@@ -1431,5 +2883,33 @@ int main() {
         std::cout << std::string(60, '-') << "\n\n";
     }
     
-    return 0;
+    runTestCases(testcases);
+    testExtendMCDBacktracks();
+    testSymbolTable();
+    testDynamicBitset();
+    testRelationIndex();
+    testParallelMCDs(testcases);
+    testParallelCovers(testcases);
+    testRewritingGenerator();
+    testCostRanking();
+    testRewritingCache();
+    testContainmentPruning(testcases);
+    testQueryMinimization();
+    testViewCatalog();
+    testRewriteBatch(testcases);
+    testCompatibilityMatrix(testcases);
+    testDancingLinks(testcases);
+    testIntervalIndex();
+    testExecuteRewritings(testcases);
+    testHashJoin();
+    testTableLoader();
+    testColumnarFile();
+    testIncrementalMaintenance();
+    testHyperLogLog();
+    testStatisticsBuilder();
+    testInequalities();
+    
+    std::cout << (failures == 0 ? "All checks passed\n" 
+                                : std::to_string(failures) + " checks failed\n");
+    return failures == 0 ? 0 : 1;
 }